@@ -0,0 +1,145 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "smartcalc_ct_expr.h"
+#include "smartcalc_model.h"
+#include "smartcalc_simd.h"
+#include "smartcalc_thread_pool.h"
+
+namespace {
+
+// Выражение вида "1+x*2-x+..." из заданного числа токенов
+std::string makeExpression(std::size_t tokens) {
+    static const char* const kOperators[] = {"+", "*", "-", "/"};
+    std::string expression = "1";
+    std::size_t count = 1;
+    for (std::size_t i = 0; count + 2 <= tokens; ++i, count += 2) {
+        expression += kOperators[i % 4];
+        expression += (i % 3 == 0) ? "x" : "2";
+    }
+    return expression;
+}
+
+// Время компиляции выражения в наносекундах на токен (лучшее из нескольких)
+double compileNsPerToken(s21::SmartCalcModel& model, const std::string& expression,
+                         std::size_t tokens) {
+    double best = 0;
+    for (int run = 0; run < 3; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        s21::CompiledExpression compiled = model.compile(expression);
+        auto stop = std::chrono::steady_clock::now();
+        if (compiled.empty()) return 0;
+        double ns = std::chrono::duration<double, std::nano>(stop - start).count() / tokens;
+        if (run == 0 || ns < best) best = ns;
+    }
+    return best;
+}
+
+// Масштабирование компиляции: время на токен должно оставаться постоянным
+int benchCompileScaling() {
+    s21::SmartCalcModel model;
+    std::printf("compile scaling\n%12s %14s\n", "tokens", "ns/token");
+    double first = 0, last = 0;
+    for (std::size_t tokens = 1000; tokens <= 1000000; tokens *= 10) {
+        std::string expression = makeExpression(tokens);
+        double ns = compileNsPerToken(model, expression, tokens);
+        std::printf("%12zu %14.2f\n", tokens, ns);
+        if (first == 0) first = ns;
+        last = ns;
+    }
+    // При квадратичном росте отношение было бы порядка 1000
+    double ratio = last / first;
+    std::printf("ratio 1M/1K: %.2f (%s)\n\n", ratio, ratio < 4 ? "linear" : "NOT linear");
+    return ratio < 4 ? 0 : 1;
+}
+
+// Пропускная способность разбора на тексте с длинными числами и функциями
+void benchLexer() {
+    std::string expression = "0";
+    while (expression.size() < (1u << 20)) expression += "+3.14159*sin(x)-2.71828/sqrt(x+1.5)+log(12.75)*x";
+    s21::SmartCalcModel model;
+    double best = 0;
+    for (int run = 0; run < 3; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        s21::CompiledExpression compiled = model.compile(expression);
+        auto stop = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(stop - start).count();
+        if (run == 0 || seconds < best) best = seconds;
+    }
+    std::printf("tokenize + compile\n%12s %14s\n%12.2f %14.2f\n\n", "MB", "MB/s",
+                expression.size() / 1e6, expression.size() / 1e6 / best);
+}
+
+// Пакетное вычисление против вызова parse() на каждую точку
+void benchBatch() {
+    const std::string expression = "sin(x)*x^2+sqrt(x+1)/(x+2)";
+    const std::size_t count = 1000000;
+    s21::SmartCalcModel model;
+    std::vector<double> xs(count), ys(count);
+    for (std::size_t i = 0; i < count; ++i) xs[i] = i * 1e-6;
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < count / 100; ++i) ys[i] = model.parse(expression, xs[i]);
+    auto stop = std::chrono::steady_clock::now();
+    double parse_ns = std::chrono::duration<double, std::nano>(stop - start).count() / (count / 100);
+
+    s21::CompiledExpression compiled = model.compile(expression);
+    start = std::chrono::steady_clock::now();
+    model.evaluate(compiled, xs, ys);
+    stop = std::chrono::steady_clock::now();
+    double batch_ns = std::chrono::duration<double, std::nano>(stop - start).count() / count;
+
+    start = std::chrono::steady_clock::now();
+    model.evaluateParallel(compiled, xs, ys);
+    stop = std::chrono::steady_clock::now();
+    double parallel_ns = std::chrono::duration<double, std::nano>(stop - start).count() / count;
+
+    // Машинный код против интерпретатора байт-кода
+    s21::CompiledExpression jitted = model.compile(expression, {.jit = true});
+    double scalar_ns[2] = {0, 0};
+    const s21::CompiledExpression* programs[2] = {&compiled, &jitted};
+    for (int k = 0; k < 2; ++k) {
+        start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < count / 10; ++i) ys[i] = programs[k]->evaluate(xs[i]);
+        stop = std::chrono::steady_clock::now();
+        scalar_ns[k] = std::chrono::duration<double, std::nano>(stop - start).count() / (count / 10);
+    }
+    // Выражение, разобранное при компиляции программы
+    using Fixed = s21::ct_expr<"sin(x)*x^2+sqrt(x+1)/(x+2)">;
+    start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < count / 10; ++i) ys[i] = Fixed::evaluate(xs[i]);
+    stop = std::chrono::steady_clock::now();
+    double constexpr_ns = std::chrono::duration<double, std::nano>(stop - start).count() / (count / 10);
+
+    start = std::chrono::steady_clock::now();
+    model.evaluate(jitted, xs, ys);
+    stop = std::chrono::steady_clock::now();
+    double batch_jit_ns = std::chrono::duration<double, std::nano>(stop - start).count() / count;
+
+    // Одинарная точность на массивах float
+    s21::CompiledExpression single = model.compile(expression, {.precision = s21::Precision::FLOAT});
+    std::vector<float> xs_float(xs.begin(), xs.end()), ys_float(count);
+    start = std::chrono::steady_clock::now();
+    single.evaluate(xs_float, ys_float);
+    stop = std::chrono::steady_clock::now();
+    double batch_float_ns = std::chrono::duration<double, std::nano>(stop - start).count() / count;
+
+    std::printf("batch evaluation (%s, %zu threads, jit %s)\n%12s %14s\n", s21::simd::isa(),
+                s21::ThreadPool::instance().size(), jitted.jitted() ? "on" : "off", "mode",
+                "ns/point");
+    std::printf("%12s %14.2f\n%12s %14.2f\n%12s %14.2f\n%12s %14.2f\n", "parse", parse_ns, "scalar",
+                scalar_ns[0], "scalar jit", scalar_ns[1], "ct_expr", constexpr_ns);
+    std::printf("%12s %14.2f\n%12s %14.2f\n%12s %14.2f\n%12s %14.2f\n\n", "batch", batch_ns,
+                "batch float", batch_float_ns, "batch jit", batch_jit_ns, "parallel", parallel_ns);
+}
+
+}  // namespace
+
+int main() {
+    int status = benchCompileScaling();
+    benchLexer();
+    benchBatch();
+    return status;
+}
@@ -10,8 +10,18 @@ QMAKE_QMAKE = /Users/nikitapotapov/Qt/5.15.16/macos/bin/qmake
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 5.15.16
 
 SOURCES += \
+    ../smartcalc_batch.cpp \
+    ../smartcalc_cache.cpp \
     ../smartcalc_controller.cpp \
+    ../smartcalc_dual.cpp \
+    ../smartcalc_integrator.cpp \
+    ../smartcalc_interval.cpp \
+    ../smartcalc_jit.cpp \
     ../smartcalc_model.cpp \
+    ../smartcalc_optimizer.cpp \
+    ../smartcalc_simd.cpp \
+    ../smartcalc_solver.cpp \
+    ../smartcalc_thread_pool.cpp \
     ../smartcalc_view.cpp \
     credit.cpp \
     deposit.cpp \
@@ -20,8 +30,16 @@ SOURCES += \
     qcustomplot.cpp
 
 HEADERS += \
+    ../smartcalc_cache.h \
     ../smartcalc_controller.h \
+    ../smartcalc_ct_expr.h \
+    ../smartcalc_integrator.h \
+    ../smartcalc_jit.h \
+    ../smartcalc_keywords.h \
     ../smartcalc_model.h \
+    ../smartcalc_simd.h \
+    ../smartcalc_solver.h \
+    ../smartcalc_thread_pool.h \
     ../smartcalc_view.h \
     credit.h \
     deposit.h \
@@ -17,7 +17,7 @@ int is_sign = 0;
 int is_x = 0;
 
 MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent), ui(new Ui::MainWindow), controller_(&model_) {
+    : QMainWindow(parent), ui(new Ui::MainWindow) {
   ui->setupUi(this);
 
   connect(ui->pushButton_0, SIGNAL(clicked()), this, SLOT(digits_numbers()));
@@ -239,12 +239,13 @@ void MainWindow::on_pushButton_graph_clicked() {
     ui->widget->yAxis->setRange(result_2, result_1);
     N = (xEnd - xBegin) / h + 2;
 
+    s21::CompiledExpression compiled = controller_.compileExpression(expression.toStdString());
     for (double X = xBegin; X <= xEnd; X += h) {
         x.push_back(X);
-        
-        double yValue = controller_.calculateExpression(expression.toStdString(), Y * X);
-        y.push_back(yValue);
+        y.push_back(Y * X);
     }
+    controller_.calculateBatch(compiled, std::span<const double>(y.data(), y.size()),
+                               std::span<double>(y.data(), y.size()));
 
     ui->widget->addGraph();
     ui->widget->graph(0)->addData(x, y);
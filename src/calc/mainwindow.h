@@ -20,7 +20,6 @@ class MainWindow : public QMainWindow {
   MainWindow(QWidget *parent = nullptr);
   ~MainWindow();
   Ui::MainWindow *ui;
-  s21::SmartCalcModel model_;
   s21::SmartCalcController controller_; 
 
  private:
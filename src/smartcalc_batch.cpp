@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+#include "smartcalc_jit.h"
+#include "smartcalc_model.h"
+#include "smartcalc_simd.h"
+#include "smartcalc_thread_pool.h"
+
+namespace s21 {
+
+namespace {
+
+// Число точек x, обрабатываемых одной инструкцией программы
+constexpr std::size_t kBlockSize = 256;
+
+// Отметка точек, в которых аргумент вне области определения. В invalid
+// хранится вид первой ошибки точки, как при скалярном вычислении
+template <class T, class Predicate>
+void markInvalid(const T* a, std::uint8_t* invalid, std::size_t lanes, ErrorKind kind,
+                 Predicate predicate) {
+    for (std::size_t i = 0; i < lanes; ++i) {
+        if (!invalid[i] && predicate(a[i])) invalid[i] = static_cast<std::uint8_t>(kind);
+    }
+}
+
+// Поэлементное применение скалярной функции
+template <class T, class Function>
+void apply(T* a, std::size_t lanes, Function function) {
+    for (std::size_t i = 0; i < lanes; ++i) a[i] = function(a[i]);
+}
+
+}  // namespace
+
+void CompiledExpression::evaluate(std::span<const double> x_values, std::span<double> results,
+                                  std::span<std::uint8_t> valid) const {
+    evaluateBatch(x_values, results, valid, {});
+}
+
+void CompiledExpression::evaluate(std::span<const float> x_values, std::span<float> results,
+                                  std::span<std::uint8_t> valid) const {
+    evaluateBatch(x_values, results, valid, {});
+}
+
+ErrorKind CompiledExpression::tryEvaluate(std::span<const double> x_values, std::span<double> results,
+                                          std::span<ErrorKind> errors) const noexcept {
+    if (x_values.size() != results.size() * variables_ || (!errors.empty() && errors.size() != results.size())) {
+        return ErrorKind::BATCH_SIZE;
+    }
+    try {
+        evaluateBatch(x_values, results, {}, errors);
+    } catch (const std::bad_alloc&) {
+        // Буфер потока не удалось увеличить
+        return ErrorKind::OUT_OF_MEMORY;
+    }
+    return ErrorKind::NONE;
+}
+
+void CompiledExpression::evaluateParallel(std::span<const double> x_values, std::span<double> results,
+                                          std::span<std::uint8_t> valid, std::size_t chunk_size,
+                                          ThreadPool& pool) const {
+    evaluateParallelBatch(x_values, results, valid, chunk_size, pool);
+}
+
+void CompiledExpression::evaluateParallel(std::span<const float> x_values, std::span<float> results,
+                                          std::span<std::uint8_t> valid, std::size_t chunk_size,
+                                          ThreadPool& pool) const {
+    evaluateParallelBatch(x_values, results, valid, chunk_size, pool);
+}
+
+// Пакетное вычисление блоками по kBlockSize точек
+template <class In, class Out>
+void CompiledExpression::evaluateBatch(std::span<const In> x_values, std::span<Out> results,
+                                       std::span<std::uint8_t> valid,
+                                       std::span<ErrorKind> errors) const {
+    checkBatch(x_values.size(), results.size(), valid.size(), errors.size());
+    if (code_.empty()) {
+        std::fill(results.begin(), results.end(), Out(0));
+        std::fill(valid.begin(), valid.end(), 1);
+        std::fill(errors.begin(), errors.end(), ErrorKind::NONE);
+        return;
+    }
+    calcPoints(x_values, results, valid, errors);
+}
+
+// Параллельное пакетное вычисление: отрезки по chunk_size точек распределяются
+// по потокам пула. Точки вычисляются независимо, поэтому результат не зависит
+// от числа потоков и размера отрезка
+template <class In, class Out>
+void CompiledExpression::evaluateParallelBatch(std::span<const In> x_values, std::span<Out> results,
+                                               std::span<std::uint8_t> valid, std::size_t chunk_size,
+                                               ThreadPool& pool) const {
+    checkBatch(x_values.size(), results.size(), valid.size(), 0);
+    if (code_.empty()) {
+        evaluateBatch(x_values, results, valid, {});
+        return;
+    }
+    pool.parallelFor(results.size(), chunk_size, [&](std::size_t begin, std::size_t end) {
+        // У каждого потока свой буфер стека
+        calcPoints(x_values.subspan(begin * variables_, (end - begin) * variables_),
+                   results.subspan(begin, end - begin),
+                   valid.empty() ? valid : valid.subspan(begin, end - begin), {});
+    });
+}
+
+void CompiledExpression::checkBatch(std::size_t inputs, std::size_t outputs, std::size_t valid,
+                                    std::size_t errors) const {
+    if (inputs != outputs * variables_ || (valid != 0 && valid != outputs) ||
+        (errors != 0 && errors != outputs)) {
+        throw std::invalid_argument(errorMessage(ErrorKind::BATCH_SIZE));
+    }
+}
+
+// Буфер потока: стек, затем блок привязок и блок результатов для случая,
+// когда тип массивов отличается от точности выражения. Блок привязок также
+// хранит копию входа при вычислении машинным кодом на месте
+template <class In, class Out>
+void CompiledExpression::calcPoints(std::span<const In> x_values, std::span<Out> results,
+                                    std::span<std::uint8_t> valid, std::span<ErrorKind> errors) const {
+    const std::size_t size = (temps_ + depth_ + variables_ + 1) * kBlockSize;
+    if (precision_ == Precision::FLOAT) {
+        calcRange(x_values, results, valid, errors, scratch<float>(size));
+    } else {
+        calcRange(x_values, results, valid, errors, scratch<double>(size));
+    }
+}
+
+template <class T, class In, class Out>
+void CompiledExpression::calcRange(std::span<const In> x_values, std::span<Out> results,
+                                   std::span<std::uint8_t> valid, std::span<ErrorKind> errors,
+                                   T* stack) const {
+    std::array<std::uint8_t, kBlockSize> invalid;
+    T* inputs = stack + (temps_ + depth_) * kBlockSize;
+    T* outputs = inputs + variables_ * kBlockSize;
+    for (std::size_t offset = 0; offset < results.size(); offset += kBlockSize) {
+        std::size_t lanes = std::min(kBlockSize, results.size() - offset);
+        const In* rows = x_values.data() + offset * variables_;
+        if constexpr (std::is_same_v<In, T> && std::is_same_v<Out, T>) {
+            calcBlock(rows, results.data() + offset, invalid.data(), lanes, stack);
+        } else {
+            // Приведение привязок и результатов к точности выражения
+            const T* block = inputs;
+            if constexpr (std::is_same_v<In, T>) {
+                block = rows;
+            } else {
+                std::transform(rows, rows + lanes * variables_, inputs, [](In v) { return static_cast<T>(v); });
+            }
+            calcBlock(block, outputs, invalid.data(), lanes, stack);
+            std::transform(outputs, outputs + lanes, results.data() + offset,
+                           [](T v) { return static_cast<Out>(v); });
+        }
+        for (std::size_t i = 0; i < lanes && !valid.empty(); ++i) {
+            valid[offset + i] = invalid[i] ? 0 : 1;
+        }
+        for (std::size_t i = 0; i < lanes && !errors.empty(); ++i) {
+            errors[offset + i] = static_cast<ErrorKind>(invalid[i]);
+        }
+    }
+}
+
+// Вычисление одного блока: каждая инструкция обрабатывает сразу все точки блока.
+// Привязки точки i занимают x_values[i * variables_ ...]. Ошибки области
+// определения не бросают исключение, а отмечаются в invalid. sin, cos, ln, log
+// и pow считаются векторными ядрами simd и отличаются от скалярного
+// вычисления (libm) не больше чем на 1 ulp (log - на 2 ulp)
+template <class T>
+void CompiledExpression::calcBlock(const T* x_values, T* results, std::uint8_t* invalid,
+                                   std::size_t lanes, T* stack) const {
+    // Машинный код есть только у выражений двойной точности. Без AVX2 блок
+    // считает интерпретатор: скалярный код вызывает libm, а не ядра simd
+    if constexpr (std::is_same_v<T, double>) {
+        if (jit_ && jit_->vectorized()) {
+            // Интерпретатору нужны привязки точек с ошибкой уже после записи
+            // результатов. Если результаты пишутся поверх входа, блок привязок
+            // сначала копируется в буфер за стеком (его размер учтен в calcPoints)
+            const double* rows = x_values;
+            std::less<const double*> before;
+            if (before(results, x_values + lanes * variables_) && before(x_values, results + lanes)) {
+                double* saved = stack + (temps_ + depth_) * kBlockSize;
+                std::copy_n(x_values, lanes * variables_, saved);
+                rows = saved;
+            }
+            jit_->runBlock(rows, variables_, results, invalid, lanes);
+            // Машинный код отмечает только факт ошибки; ее вид дает интерпретатор
+            for (std::size_t i = 0; i < lanes; ++i) {
+                if (!invalid[i]) continue;
+                EvalResult result = calcExpression(rows + i * variables_, stack);
+                invalid[i] = static_cast<std::uint8_t>(result.error().kind);
+                results[i] = result.value();
+            }
+            finishBlock(results, results, invalid, lanes);
+            return;
+        }
+    }
+
+    std::fill_n(invalid, lanes, 0);
+    // Первые temps_ блоков занимают временные значения, за ними идет стек
+    std::size_t size = temps_;  // Число занятых блоков
+    auto slot = [stack](std::size_t index) { return stack + index * kBlockSize; };
+
+    for (const Instruction& ins : code_) {
+        switch (ins.type) {
+            case Type::NUMBER:
+                std::fill_n(slot(size++), lanes, static_cast<T>(constants_[ins.operand]));
+                break;
+
+            case Type::X: {
+                // Столбец переменной из строк привязок
+                T* a = slot(size++);
+                if (variables_ == 1) {
+                    std::copy_n(x_values, lanes, a);
+                } else {
+                    for (std::size_t i = 0; i < lanes; ++i) a[i] = x_values[i * variables_ + ins.operand];
+                }
+                break;
+            }
+
+            case Type::LOAD:
+                std::copy_n(slot(ins.operand), lanes, slot(size++));
+                break;
+
+            case Type::STORE:
+                std::copy_n(slot(size - 1), lanes, slot(ins.operand));
+                break;
+
+            case Type::PLUS:
+            case Type::MINUS:
+            case Type::MULT: {
+                T* a = slot(size - 2);
+                simd::binary(ins.type, a, slot(size - 1), a, lanes);
+                --size;
+                break;
+            }
+
+            case Type::DIV: {
+                T* a = slot(size - 2);
+                T* b = slot(size - 1);
+                markInvalid(b, invalid, lanes, ErrorKind::DIVISION_BY_ZERO, [](T v) { return v == 0; });
+                simd::binary(Type::DIV, a, b, a, lanes);
+                --size;
+                break;
+            }
+
+            case Type::POW: {
+                T* a = slot(size - 2);
+                T* b = slot(size - 1);
+                simd::binary(Type::POW, a, b, a, lanes);
+                --size;
+                break;
+            }
+
+            case Type::MOD: {
+                T* a = slot(size - 2);
+                T* b = slot(size - 1);
+                markInvalid(b, invalid, lanes, ErrorKind::MODULO_BY_ZERO, [](T v) { return v == 0; });
+                for (std::size_t i = 0; i < lanes; ++i) a[i] = std::fmod(a[i], b[i]);
+                --size;
+                break;
+            }
+
+            case Type::SIN:
+            case Type::COS: {
+                T* a = slot(size - 1);
+                simd::unary(ins.type, a, a, lanes);
+                break;
+            }
+
+            case Type::TAN:
+                apply(slot(size - 1), lanes, [](T v) { return std::tan(v); });
+                break;
+
+            case Type::COT: {
+                T* a = slot(size - 1);
+                apply(a, lanes, [](T v) { return std::tan(v); });
+                markInvalid(a, invalid, lanes, ErrorKind::COT_UNDEFINED, [](T v) { return v == 0; });
+                apply(a, lanes, [](T v) { return T(1) / v; });
+                break;
+            }
+
+            case Type::ASIN: {
+                T* a = slot(size - 1);
+                markInvalid(a, invalid, lanes, ErrorKind::ASIN_DOMAIN, [](T v) { return v < -1 || v > 1; });
+                apply(a, lanes, [](T v) { return std::asin(v); });
+                break;
+            }
+
+            case Type::ACOS: {
+                T* a = slot(size - 1);
+                markInvalid(a, invalid, lanes, ErrorKind::ACOS_DOMAIN, [](T v) { return v < -1 || v > 1; });
+                apply(a, lanes, [](T v) { return std::acos(v); });
+                break;
+            }
+
+            case Type::ATAN:
+                apply(slot(size - 1), lanes, [](T v) { return std::atan(v); });
+                break;
+
+            case Type::SQRT: {
+                T* a = slot(size - 1);
+                markInvalid(a, invalid, lanes, ErrorKind::SQRT_DOMAIN, [](T v) { return v < 0; });
+                simd::unary(Type::SQRT, a, a, lanes);
+                break;
+            }
+
+            case Type::LOG: {
+                T* a = slot(size - 1);
+                markInvalid(a, invalid, lanes, ErrorKind::LOG_DOMAIN, [](T v) { return v <= 0; });
+                simd::unary(Type::LOG, a, a, lanes);
+                break;
+            }
+
+            case Type::LN: {
+                T* a = slot(size - 1);
+                markInvalid(a, invalid, lanes, ErrorKind::LN_DOMAIN, [](T v) { return v <= 0; });
+                simd::unary(Type::LN, a, a, lanes);
+                break;
+            }
+
+            case Type::UNARY_MINUS: {
+                T* a = slot(size - 1);
+                simd::unary(Type::UNARY_MINUS, a, a, lanes);
+                break;
+            }
+
+            default:
+                // Программа проверена при компиляции; неизвестная инструкция
+                // делает ошибочными все точки блока, исключение не бросается
+                std::fill_n(invalid, lanes, static_cast<std::uint8_t>(ErrorKind::UNKNOWN_OPERATOR));
+                std::fill_n(results, lanes, std::numeric_limits<T>::quiet_NaN());
+                return;
+        }
+    }
+
+    finishBlock(slot(temps_), results, invalid, lanes);
+}
+
+// Проверка результата в каждой точке
+template <class T>
+void CompiledExpression::finishBlock(const T* top, T* results, std::uint8_t* invalid, std::size_t lanes) {
+    for (std::size_t i = 0; i < lanes; ++i) {
+        if (invalid[i] || std::isnan(top[i]) || std::isinf(top[i])) {
+            if (!invalid[i]) invalid[i] = static_cast<std::uint8_t>(ErrorKind::NOT_FINITE);
+            results[i] = std::numeric_limits<T>::quiet_NaN();
+        } else {
+            results[i] = top[i];
+        }
+    }
+}
+
+}  // namespace s21
@@ -0,0 +1,70 @@
+#include "smartcalc_cache.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace s21 {
+
+ExpressionCache::ExpressionCache(std::size_t capacity) : capacity_(std::max<std::size_t>(capacity, 1)) {}
+
+std::string ExpressionCache::normalize(const std::string& expression) {
+    // Символы чисел и имен: пробел между ними разделяет токены ("s in", "x 1")
+    auto word = [](char ch) { return std::isalnum(static_cast<unsigned char>(ch)) || ch == '_' || ch == '.'; };
+    std::string key;
+    key.reserve(expression.size());
+    bool space = false;  // Пропущен ли пробел перед текущим символом
+    for (char ch : expression) {
+        if (ch == ' ') {
+            space = true;
+            continue;
+        }
+        if (space && !key.empty() && word(key.back()) && word(ch)) key += ' ';
+        key += ch;
+        space = false;
+    }
+    return key;
+}
+
+std::shared_ptr<const CompiledExpression> ExpressionCache::find(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        ++stats_.misses;
+        return nullptr;
+    }
+    ++stats_.hits;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->second;
+}
+
+void ExpressionCache::insert(const std::string& key, std::shared_ptr<const CompiledExpression> compiled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        // Выражение уже скомпилировано другим потоком
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return;
+    }
+    entries_.emplace_front(key, std::move(compiled));
+    index_.emplace(key, entries_.begin());
+    if (entries_.size() > capacity_) {
+        index_.erase(entries_.back().first);
+        entries_.pop_back();
+        ++stats_.evictions;
+    }
+}
+
+ExpressionCache::Stats ExpressionCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.size = entries_.size();
+    return stats;
+}
+
+void ExpressionCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    index_.clear();
+}
+
+}  // namespace s21
@@ -0,0 +1,56 @@
+#ifndef SMARTCALC_CACHE_H
+#define SMARTCALC_CACHE_H
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "smartcalc_model.h"
+
+namespace s21 {
+
+// Потокобезопасный LRU-кэш скомпилированных выражений.
+// Ключ - нормализованный текст выражения (без лишних пробелов)
+class ExpressionCache {
+public:
+    // Счетчики обращений к кэшу
+    struct Stats {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t evictions = 0;
+        std::size_t size = 0;
+    };
+
+    explicit ExpressionCache(std::size_t capacity);
+
+    // Удаление пробелов, которые parse() пропускает. Пробелы между символами
+    // чисел и имен сводятся к одному: они разделяют токены ("s in(1)" - ошибка),
+    // поэтому ключ компилируется так же, как исходный текст
+    static std::string normalize(const std::string& expression);
+
+    // Поиск по нормализованному ключу; nullptr при промахе
+    std::shared_ptr<const CompiledExpression> find(const std::string& key);
+    // Добавление выражения; при переполнении вытесняется самое давнее
+    void insert(const std::string& key, std::shared_ptr<const CompiledExpression> compiled);
+
+    Stats stats() const;
+    std::size_t capacity() const { return capacity_; }
+    void clear();
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<const CompiledExpression>>;
+
+    std::size_t capacity_;
+    std::list<Entry> entries_;  // От недавно использованных к давним
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    Stats stats_;
+    mutable std::mutex mutex_;
+};
+
+}  // namespace s21
+
+#endif  // SMARTCALC_CACHE_H
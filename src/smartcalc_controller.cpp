@@ -1,9 +1,67 @@
 #include "smartcalc_controller.h"
 
-// Конструктор контроллера принимает указатель на модель
-s21::SmartCalcController::SmartCalcController(SmartCalcModel* model) : model_(model) {}
+#include <utility>
+
+s21::SmartCalcController::SmartCalcController(std::size_t cache_capacity)
+    : SmartCalcController(std::make_shared<const SmartCalcModel>(), cache_capacity) {}
+
+// Конструктор контроллера разделяет владение моделью
+s21::SmartCalcController::SmartCalcController(std::shared_ptr<const SmartCalcModel> model,
+                                              std::size_t cache_capacity)
+    : model_(std::move(model)), cache_(cache_capacity) {}
 
 // Метод контроллера для вычисления выражения
-double s21::SmartCalcController::calculateExpression(const std::string& expression, double x_value) {
-    return model_->parse(expression, x_value);
+double s21::SmartCalcController::calculateExpression(const std::string& expression,
+                                                    double x_value) const {
+    return compiled(expression)->evaluate(x_value);
+}
+
+// Метод контроллера для компиляции выражения. Программа из кэша собрана по
+// ключу, поэтому подходит только для текста, совпадающего с ключом: иначе
+// позиции ошибок не совпали бы с позициями в исходном тексте
+s21::CompiledExpression s21::SmartCalcController::compileExpression(
+    const std::string& expression) const {
+    if (ExpressionCache::normalize(expression) != expression) return model_->compile(expression);
+    return *compiled(expression);
+}
+
+// Метод контроллера для пакетного вычисления выражения
+void s21::SmartCalcController::calculateBatch(const CompiledExpression& compiled,
+                                              std::span<const double> x_values,
+                                              std::span<double> results,
+                                              std::span<std::uint8_t> valid) const {
+    model_->evaluate(compiled, x_values, results, valid);
+}
+
+// Метод контроллера для параллельного пакетного вычисления выражения
+void s21::SmartCalcController::calculateBatchParallel(const CompiledExpression& compiled,
+                                                      std::span<const double> x_values,
+                                                      std::span<double> results,
+                                                      std::span<std::uint8_t> valid,
+                                                      std::size_t chunk_size) const {
+    model_->evaluateParallel(compiled, x_values, results, valid, chunk_size);
+}
+
+// Метод контроллера для численного интегрирования выражения
+s21::IntegrationResult s21::SmartCalcController::calculateIntegral(const std::string& expression,
+                                                                   double a, double b,
+                                                                   IntegrationOptions options) const {
+    return Integrator(options).integrate(*compiled(expression), a, b);
+}
+
+// Поиск выражения в кэше; при промахе компилируется и запоминается ключ:
+// он разбирается так же, как исходный текст, но позиции ошибок отсчитываются в нем
+std::shared_ptr<const s21::CompiledExpression> s21::SmartCalcController::compiled(
+    const std::string& expression) const {
+    std::string key = ExpressionCache::normalize(expression);
+    if (key.empty()) {
+        // Пустые выражения не кэшируются, чтобы сохранить поведение parse()
+        return std::make_shared<const CompiledExpression>(model_->compile(expression));
+    }
+    std::shared_ptr<const CompiledExpression> result = cache_.find(key);
+    if (!result) {
+        result = std::make_shared<const CompiledExpression>(model_->compile(key));
+        cache_.insert(key, result);
+    }
+    return result;
 }
@@ -1,20 +1,57 @@
 #ifndef SMARTCALC_CONTROLLER_H
 #define SMARTCALC_CONTROLLER_H
 
+#include <memory>
+#include <span>
 #include <string>
+#include "smartcalc_cache.h"
+#include "smartcalc_integrator.h"
 #include "smartcalc_model.h"
 
 // Контроллер для управления моделью
 namespace s21 {
 class SmartCalcController {
 public:
-    explicit SmartCalcController(SmartCalcModel* model);
+    // Емкость кэша скомпилированных выражений по умолчанию
+    static constexpr std::size_t kDefaultCacheCapacity = 512;
 
-    // Метод для вычисления выражения
-    double calculateExpression(const std::string& expression, double x_value);
+    // Контроллер со своей моделью
+    explicit SmartCalcController(std::size_t cache_capacity = kDefaultCacheCapacity);
+    // Контроллер с общей моделью; модель живет, пока жив хотя бы один владелец
+    explicit SmartCalcController(std::shared_ptr<const SmartCalcModel> model,
+                                 std::size_t cache_capacity = kDefaultCacheCapacity);
+
+    // Все методы const и потокобезопасны: кэш синхронизирован внутри
+
+    // Метод для вычисления выражения (повторные формулы берутся из кэша)
+    double calculateExpression(const std::string& expression, double x_value) const;
+
+    // Метод для однократной компиляции выражения
+    CompiledExpression compileExpression(const std::string& expression) const;
+
+    // Метод для вычисления выражения на массиве значений x
+    void calculateBatch(const CompiledExpression& compiled, std::span<const double> x_values,
+                        std::span<double> results, std::span<std::uint8_t> valid = {}) const;
+
+    // Метод для параллельного вычисления выражения на массиве значений x
+    void calculateBatchParallel(const CompiledExpression& compiled, std::span<const double> x_values,
+                                std::span<double> results, std::span<std::uint8_t> valid = {},
+                                std::size_t chunk_size = CompiledExpression::kDefaultChunkSize) const;
+
+    // Определенный интеграл выражения от a до b; options.max_evaluations - бюджет
+    // вычислений функции, при его исчерпании converged = false
+    IntegrationResult calculateIntegral(const std::string& expression, double a, double b,
+                                        IntegrationOptions options = {}) const;
+
+    // Счетчики кэша скомпилированных выражений
+    ExpressionCache::Stats cacheStats() const { return cache_.stats(); }
 
 private:
-    SmartCalcModel* model_;  // Указатель на модель
+    // Скомпилированное выражение из кэша или новое при промахе
+    std::shared_ptr<const CompiledExpression> compiled(const std::string& expression) const;
+
+    std::shared_ptr<const SmartCalcModel> model_;  // Модель без состояния
+    mutable ExpressionCache cache_;  // Кэш скомпилированных выражений
 };
 
 } // namespace s21
@@ -0,0 +1,522 @@
+#ifndef SMARTCALC_CT_EXPR_H
+#define SMARTCALC_CT_EXPR_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "smartcalc_dag.h"
+#include "smartcalc_keywords.h"
+#include "smartcalc_model.h"
+
+namespace s21 {
+
+// Строковый литерал как параметр шаблона
+template <std::size_t N>
+struct FixedString {
+    char data[N]{};
+
+    constexpr FixedString(const char (&text)[N]) { std::copy_n(text, N, data); }
+    constexpr std::string_view view() const { return {data, N - 1}; }
+};
+
+// Разбор выражения во время компиляции. Грамматика, приоритеты и сообщения
+// об ошибках те же, что у SmartCalcModel::compile; ошибка разбора в
+// константном вычислении становится ошибкой компиляции
+namespace ct {
+
+// Инструкция программы; top - глубина стека перед ее выполнением
+struct Step {
+    Type type = Type::NUMBER;
+    double value = 0;            // Значение числа
+    std::uint32_t operand = 0;   // Номер слота переменной или временного значения
+    std::uint32_t position = 0;  // Позиция токена в строке выражения
+    std::size_t top = 0;
+};
+
+// Каждый токен дает не больше двух узлов графа, а узел - не больше четырех
+// инструкций: сам узел, STORE и по одной на каждый операнд
+template <std::size_t Capacity>
+struct Program {
+    std::array<Step, 8 * Capacity> code{};
+    std::size_t size = 0;   // Число инструкций
+    std::size_t depth = 0;  // Максимальная глубина стека
+    std::size_t temps = 0;  // Число временных значений общих подвыражений
+};
+
+constexpr bool isDigit(char ch) { return ch >= '0' && ch <= '9'; }
+constexpr bool isAlpha(char ch) { return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z'); }
+constexpr bool isIdentifier(char ch) { return isDigit(ch) || isAlpha(ch) || ch == '_'; }
+
+constexpr long double power10(int exponent) {
+    long double result = 1;
+    for (int i = 0; i < exponent; ++i) result *= 10;
+    return result;
+}
+
+// Число из цифр и точки; пробелы внутри числа пропускаются. До 15 значащих
+// цифр значение округлено правильно и совпадает с from_chars; у более длинных
+// чисел возможно расхождение в последнем бите
+constexpr double parseNumber(std::string_view digits) {
+    constexpr std::uint64_t kExact = std::uint64_t{1} << 53;
+    std::uint64_t mantissa = 0;
+    int exponent = 0;  // Отброшенные цифры целой части
+    int fraction = 0;  // Учтенные цифры дробной части
+    bool dot = false, any = false;
+    for (char ch : digits) {
+        if (ch == ' ') continue;
+        if (ch == '.') {
+            if (dot) throw std::invalid_argument("Invalid number in expression.");
+            dot = true;
+            continue;
+        }
+        any = true;
+        if (mantissa <= (UINT64_MAX - 9) / 10) {
+            mantissa = mantissa * 10 + static_cast<std::uint64_t>(ch - '0');
+            if (dot) ++fraction;
+        } else if (!dot) {
+            ++exponent;
+        }
+    }
+    if (!any) throw std::invalid_argument("Invalid number in expression.");
+    if (mantissa < kExact && exponent == 0 && fraction <= 22) {
+        // Оба операнда точны, деление округляется один раз
+        return static_cast<double>(mantissa) / static_cast<double>(power10(fraction));
+    }
+    return static_cast<double>(mantissa * power10(exponent) / power10(fraction));
+}
+
+// Слот переменной: точное совпадение имени или самое длинное имя в начале
+constexpr std::size_t matchVariable(std::string_view name, std::span<const std::string_view> variables,
+                                    bool exact) {
+    std::size_t found = variables.size();
+    for (std::size_t k = 0; k < variables.size(); ++k) {
+        if (exact ? name == variables[k] : name.starts_with(variables[k]) &&
+                    (found == variables.size() || variables[k].size() > variables[found].size())) {
+            found = k;
+            if (exact) break;
+        }
+    }
+    return found;
+}
+
+// Ошибка области определения оператора с константными операндами; при
+// разборе она бросается тем же исключением, что и в SmartCalcModel::foldConstants
+constexpr ErrorKind constantError(Type type, double a, double b) {
+    switch (type) {
+        case Type::DIV:
+            return b == 0 ? ErrorKind::DIVISION_BY_ZERO : ErrorKind::NONE;
+        case Type::MOD:
+            return b == 0 ? ErrorKind::MODULO_BY_ZERO : ErrorKind::NONE;
+        case Type::COT:
+            return a == 0 ? ErrorKind::COT_UNDEFINED : ErrorKind::NONE;  // tan(a) == 0 только при a == 0
+        case Type::ASIN:
+            return a < -1 || a > 1 ? ErrorKind::ASIN_DOMAIN : ErrorKind::NONE;
+        case Type::ACOS:
+            return a < -1 || a > 1 ? ErrorKind::ACOS_DOMAIN : ErrorKind::NONE;
+        case Type::SQRT:
+            return a < 0 ? ErrorKind::SQRT_DOMAIN : ErrorKind::NONE;
+        case Type::LOG:
+            return a <= 0 ? ErrorKind::LOG_DOMAIN : ErrorKind::NONE;
+        case Type::LN:
+            return a <= 0 ? ErrorKind::LN_DOMAIN : ErrorKind::NONE;
+        default:
+            return ErrorKind::NONE;
+    }
+}
+
+// Арифметика над числами, как при свертке в foldConstants; false для
+// функций, pow и mod: их значения дает libm во время выполнения
+constexpr bool foldArithmetic(Type type, double a, double b, double& value) {
+    switch (type) {
+        case Type::PLUS:
+            value = a + b;
+            return true;
+        case Type::MINUS:
+            value = a - b;
+            return true;
+        case Type::MULT:
+            value = a * b;
+            return true;
+        case Type::DIV:
+            value = a / b;
+            return true;
+        case Type::UNARY_MINUS:
+            value = -a;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Лексер и сортировочная станция SmartCalcModel::compile в constexpr-форме,
+// затем свертка констант, как в foldConstants, и оптимизация тем же
+// ExpressionDag, что в optimizeDag
+template <std::size_t Capacity>
+constexpr Program<Capacity> compile(std::string_view expression, std::span<const std::string_view> variables) {
+    struct Token {
+        double value;
+        Priority priority;
+        Type type;
+        std::uint32_t position;
+    };
+
+    if (expression.empty()) throw std::invalid_argument("Empty expression.");
+    int balance = 0;
+    for (char ch : expression) {
+        if (ch == '(') balance++;
+        if (ch == ')') balance--;
+        if (balance < 0) break;
+    }
+    if (balance != 0) throw std::invalid_argument("Mismatched parentheses in expression.");
+    for (std::size_t k = 0; k < variables.size(); ++k) {
+        const std::string_view name = variables[k];
+        bool valid = !name.empty() && (isAlpha(name[0]) || name[0] == '_') &&
+                     std::all_of(name.begin(), name.end(), isIdentifier) &&
+                     !(kKeywordTrie.match(name) && kKeywordTrie.match(name)->name.size() == name.size()) &&
+                     matchVariable(name, variables, true) == k;
+        if (!valid) throw std::invalid_argument("Invalid variable name.");
+    }
+
+    std::array<Token, Capacity> output{};  // Программа в обратной польской записи
+    std::array<Token, Capacity> operators{};
+    std::size_t size = 0;   // Длина программы
+    std::size_t count = 0;  // Размер стека операторов
+    auto pop = [&] { output[size++] = operators[--count]; };
+
+    // Шаг сортировочной станции, как SmartCalcModel::RPN
+    auto rpn = [&](const Token& token) {
+        switch (token.type) {
+            case Type::NUMBER:
+            case Type::X:
+                output[size++] = token;
+                break;
+
+            case Type::ROUNDBRACKET_L:
+                operators[count++] = token;
+                break;
+
+            case Type::ROUNDBRACKET_R:
+                while (count > 0 && operators[count - 1].type != Type::ROUNDBRACKET_L) pop();
+                if (count > 0) --count;
+                else throw std::invalid_argument("Mismatched parentheses");
+                break;
+
+            case Type::UNARY_MINUS:
+            case Type::SIN:
+            case Type::COS:
+            case Type::TAN:
+            case Type::ASIN:
+            case Type::ACOS:
+            case Type::ATAN:
+            case Type::SQRT:
+            case Type::LOG:
+            case Type::LN:
+                operators[count++] = token;
+                break;
+
+            default:
+                while (count > 0 && operators[count - 1].type != Type::ROUNDBRACKET_L &&
+                       (operators[count - 1].priority >= token.priority && token.type != Type::POW)) {
+                    pop();
+                }
+                operators[count++] = token;
+                break;
+        }
+    };
+
+    bool has_tokens = false;
+    bool operand_expected = true;
+    auto push = [&](double value, Priority priority, Type type, std::size_t position) {
+        rpn(Token{value, priority, type, static_cast<std::uint32_t>(position)});
+        operand_expected = type != Type::NUMBER && type != Type::X && type != Type::ROUNDBRACKET_R;
+    };
+
+    for (std::size_t i = 0; i < expression.length(); ++i) {
+        const char ch = expression[i];
+        if (ch == ' ') continue;
+        has_tokens = true;
+        if (isDigit(ch) || ch == '.') {
+            std::size_t end = i;
+            for (std::size_t j = i; j < expression.length(); ++j) {
+                if (expression[j] == ' ') continue;
+                if (!isDigit(expression[j]) && expression[j] != '.') break;
+                end = j + 1;
+            }
+            push(parseNumber(expression.substr(i, end - i)), Priority::SHORT, Type::NUMBER, i);
+            i = end - 1;
+        } else if (isAlpha(ch) || ch == '_') {
+            std::size_t end = i;
+            while (end < expression.length() && isIdentifier(expression[end])) ++end;
+            const std::string_view identifier = expression.substr(i, end - i);
+            std::size_t slot = matchVariable(identifier, variables, true);
+            if (slot == variables.size()) {
+                if (const Keyword* keyword = kKeywordTrie.match(expression.substr(i))) {
+                    push(0, keyword->priority, keyword->type, i);
+                    i += keyword->name.size() - 1;
+                    continue;
+                }
+                slot = matchVariable(identifier, variables, false);
+                if (slot == variables.size()) throw std::invalid_argument("Invalid character in expression.");
+            }
+            push(static_cast<double>(slot), Priority::SHORT, Type::X, i);
+            i += variables[slot].size() - 1;
+        } else if (ch == '+') {
+            if (!operand_expected) push(0, Priority::SHORT, Type::PLUS, i);
+        } else if (ch == '-') {
+            if (operand_expected) push(0, Priority::UNARY, Type::UNARY_MINUS, i);
+            else push(0, Priority::SHORT, Type::MINUS, i);
+        } else if (ch == '*') {
+            push(0, Priority::MIDDLE, Type::MULT, i);
+        } else if (ch == '/') {
+            push(0, Priority::MIDDLE, Type::DIV, i);
+        } else if (ch == '^') {
+            push(0, Priority::HIGH, Type::POW, i);
+        } else if (ch == '(') {
+            push(0, Priority::ROUNDBRACKET, Type::ROUNDBRACKET_L, i);
+        } else if (ch == ')') {
+            push(0, Priority::ROUNDBRACKET, Type::ROUNDBRACKET_R, i);
+        } else {
+            throw std::invalid_argument("Invalid character in expression.");
+        }
+    }
+    if (!has_tokens) return Program<Capacity>{};
+    while (count > 0) {
+        if (operators[count - 1].type == Type::ROUNDBRACKET_L) throw std::invalid_argument("Mismatched parentheses");
+        pop();
+    }
+    if (size == 0) throw std::invalid_argument("Invalid RPN transformation.");
+
+    // Свертка констант, как в foldConstants: арифметика над числами
+    // сворачивается, а функции, pow и mod от чисел остаются инструкциями,
+    // но ошибки их области определения бросаются здесь же
+    struct Value {
+        std::size_t start;  // Начало кода значения
+        bool constant;
+        double value;
+    };
+    std::vector<Instruction> code;
+    std::vector<double> constants;
+    std::vector<std::uint32_t> positions;
+    std::vector<Value> stack;
+    for (std::size_t i = 0; i < size; ++i) {
+        const Token& token = output[i];
+        const int operands = operandCount(token.type);
+        if (operands < 0) throw std::invalid_argument("Unknown operator type.");
+        if (stack.size() < static_cast<std::size_t>(operands)) throw std::invalid_argument("Invalid expression.");
+        std::size_t start = code.size();
+        bool constant = token.type == Type::NUMBER;
+        double a = token.value, b = 0;
+        if (operands > 0) {
+            const Value& first = stack[stack.size() - operands];
+            start = first.start;
+            constant = first.constant && stack.back().constant;
+            a = first.value;
+            b = stack.back().value;
+            stack.resize(stack.size() - operands);
+        }
+        if (constant && operands > 0) {
+            if (ErrorKind error = constantError(token.type, a, b); error != ErrorKind::NONE) {
+                throw std::invalid_argument(errorMessage(error));
+            }
+            constant = foldArithmetic(token.type, a, b, a);
+            if (constant) {
+                code.resize(start);
+                positions.resize(start);
+            }
+        }
+        if (constant) {
+            code.push_back(Instruction{Type::NUMBER, static_cast<std::uint32_t>(constants.size())});
+            constants.push_back(a);
+        } else {
+            code.push_back(Instruction{token.type, static_cast<std::uint32_t>(token.value)});
+        }
+        positions.push_back(token.position);
+        stack.push_back(Value{start, constant, a});
+    }
+
+    // Граф выражения и запись программы - общий код с optimizeDag
+    ExpressionDag dag;
+    if (!dag.build(code, constants, positions)) throw std::invalid_argument("Invalid expression.");
+    Program<Capacity> program{};
+    dag.emit(code, constants, positions, program.temps);
+    if (code.size() > program.code.size()) throw std::invalid_argument("Expression is too long.");
+    std::size_t depth = 0;
+    for (const Instruction& ins : code) {
+        const double value = ins.type == Type::NUMBER ? constants[ins.operand] : 0;
+        program.code[program.size] = Step{ins.type, value, ins.operand, positions[program.size], depth};
+        ++program.size;
+        depth = depth - operandCount(ins.type) + 1;
+        program.depth = std::max(program.depth, depth);
+    }
+    return program;
+}
+
+// Операции с кодом, известным при компиляции; семантика и ошибки области
+// определения как у CompiledExpression::arithmetic и trigonometry
+template <Type Op>
+inline double arithmetic(double a, double b, ErrorKind& error) noexcept {
+    if constexpr (Op == Type::PLUS) {
+        return a + b;
+    } else if constexpr (Op == Type::MINUS) {
+        return a - b;
+    } else if constexpr (Op == Type::MULT) {
+        return a * b;
+    } else if constexpr (Op == Type::DIV) {
+        if (b == 0) error = ErrorKind::DIVISION_BY_ZERO;
+        return a / b;
+    } else if constexpr (Op == Type::POW) {
+        return std::pow(a, b);
+    } else {
+        static_assert(Op == Type::MOD);
+        if (b == 0) error = ErrorKind::MODULO_BY_ZERO;
+        return std::fmod(a, b);
+    }
+}
+
+template <Type Op>
+inline double trigonometry(double a, ErrorKind& error) noexcept {
+    if constexpr (Op == Type::SIN) {
+        return std::sin(a);
+    } else if constexpr (Op == Type::COS) {
+        return std::cos(a);
+    } else if constexpr (Op == Type::TAN) {
+        return std::tan(a);
+    } else if constexpr (Op == Type::COT) {
+        double tan_a = std::tan(a);
+        if (tan_a == 0) error = ErrorKind::COT_UNDEFINED;
+        return 1.0 / tan_a;
+    } else if constexpr (Op == Type::ASIN) {
+        if (a < -1 || a > 1) error = ErrorKind::ASIN_DOMAIN;
+        return std::asin(a);
+    } else if constexpr (Op == Type::ACOS) {
+        if (a < -1 || a > 1) error = ErrorKind::ACOS_DOMAIN;
+        return std::acos(a);
+    } else if constexpr (Op == Type::ATAN) {
+        return std::atan(a);
+    } else if constexpr (Op == Type::SQRT) {
+        if (a < 0) error = ErrorKind::SQRT_DOMAIN;
+        return std::sqrt(a);
+    } else if constexpr (Op == Type::LOG) {
+        if (a <= 0) error = ErrorKind::LOG_DOMAIN;
+        return std::log10(a);
+    } else if constexpr (Op == Type::LN) {
+        if (a <= 0) error = ErrorKind::LN_DOMAIN;
+        return std::log(a);
+    } else {
+        static_assert(Op == Type::UNARY_MINUS);
+        return -a;
+    }
+}
+
+}  // namespace ct
+
+// Выражение, разобранное при компиляции: s21::ct_expr<"sin(x)^2+1">.
+// Имена переменных перечисляются после выражения (по умолчанию одна x):
+// s21::ct_expr<"P*r/(1-(1+r)^(-n))", "P", "r", "n">. Синтаксическая ошибка
+// и ошибка области определения в константе (1/0, sqrt(-1)) дают ошибку
+// компиляции. Каждая инструкция разворачивается в отдельный фрагмент кода с
+// постоянными индексами стека, поэтому во время выполнения нет ни разбора,
+// ни цикла интерпретатора.
+// Программа строится теми же правилами, что у SmartCalcModel::compile (свертка
+// констант, степени и деление через умножения, общие подвыражения; граф
+// выражения - общий ExpressionDag), поэтому
+// значения, вид и позиция ошибок совпадают с evaluate. Отличия:
+//   - функции, pow и mod от констант вычисляются во время выполнения, а не
+//     при разборе: ошибка, зависящая от их значения (1/sin(0)), возникает при
+//     вычислении, а вычисленный ими показатель (x^(6 mod 4)) не раскрывается;
+//   - переполнение при свертке констант - ошибка компиляции, а не NOT_FINITE
+template <FixedString Expression, FixedString... Variables>
+class ct_expr {
+    static constexpr auto kVariables = [] {
+        if constexpr (sizeof...(Variables) == 0) {
+            return std::array<std::string_view, 1>{"x"};
+        } else {
+            return std::array<std::string_view, sizeof...(Variables)>{Variables.view()...};
+        }
+    }();
+    static constexpr ct::Program<sizeof(Expression.data)> kProgram =
+        ct::compile<sizeof(Expression.data)>(Expression.view(), kVariables);
+
+public:
+    // Число переменных: число аргументов вычисления
+    static constexpr std::size_t kVariableCount = kVariables.size();
+
+    // Число инструкций программы
+    static constexpr std::size_t size() { return kProgram.size; }
+
+    template <class... Args>
+        requires(sizeof...(Args) == kVariableCount && (std::convertible_to<Args, double> && ...))
+    static EvalResult tryEvaluate(Args... args) noexcept {
+        const std::array<double, kVariableCount> bindings{static_cast<double>(args)...};
+        if constexpr (kProgram.size == 0) {
+            return 0.0;
+        } else {
+            return run(bindings.data(), std::make_index_sequence<kProgram.size>());
+        }
+    }
+
+    template <class... Args>
+        requires(sizeof...(Args) == kVariableCount && (std::convertible_to<Args, double> && ...))
+    static double evaluate(Args... args) {
+        EvalResult result = tryEvaluate(args...);
+        if (!result) throw std::invalid_argument(errorMessage(result.error().kind));
+        return result.value();
+    }
+
+    template <class... Args>
+        requires(sizeof...(Args) == kVariableCount && (std::convertible_to<Args, double> && ...))
+    double operator()(Args... args) const {
+        return evaluate(args...);
+    }
+
+private:
+    using Stack = std::array<double, kProgram.depth>;
+    using Temps = std::array<double, kProgram.temps>;
+
+    template <std::size_t... I>
+    static EvalResult run(const double* bindings, std::index_sequence<I...>) noexcept {
+        Stack stack{};
+        Temps temps{};
+        EvalError error{ErrorKind::NONE, 0};
+        // Выполнение останавливается на первой ошибке, как в интерпретаторе
+        if (!(step<I>(stack, temps, bindings, error) && ...)) return error;
+        if (std::isnan(stack[0]) || std::isinf(stack[0])) {
+            return EvalError{ErrorKind::NOT_FINITE, kProgram.code[kProgram.size - 1].position};
+        }
+        return stack[0];
+    }
+
+    template <std::size_t I>
+    static bool step(Stack& stack, Temps& temps, const double* bindings, EvalError& error) noexcept {
+        constexpr ct::Step ins = kProgram.code[I];
+        if constexpr (ins.type == Type::NUMBER) {
+            stack[ins.top] = ins.value;
+        } else if constexpr (ins.type == Type::X) {
+            stack[ins.top] = bindings[ins.operand];
+        } else if constexpr (ins.type == Type::LOAD) {
+            stack[ins.top] = temps[ins.operand];
+        } else if constexpr (ins.type == Type::STORE) {
+            temps[ins.operand] = stack[ins.top - 1];
+        } else if constexpr (operandCount(ins.type) == 2) {
+            stack[ins.top - 2] = ct::arithmetic<ins.type>(stack[ins.top - 2], stack[ins.top - 1], error.kind);
+        } else {
+            stack[ins.top - 1] = ct::trigonometry<ins.type>(stack[ins.top - 1], error.kind);
+        }
+        if (error.kind == ErrorKind::NONE) return true;
+        error.position = ins.position;
+        return false;
+    }
+};
+
+}  // namespace s21
+
+#endif  // SMARTCALC_CT_EXPR_H
@@ -0,0 +1,303 @@
+#ifndef SMARTCALC_DAG_H
+#define SMARTCALC_DAG_H
+
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "smartcalc_model.h"
+
+namespace s21 {
+
+inline constexpr std::uint32_t kNoOperand = UINT32_MAX;
+
+// Наибольший показатель степени, раскрываемый в умножения. Возведение в
+// квадрат удваивает относительную погрешность, поэтому для x^2..x^4
+// расхождение с std::pow не превышает 2 ulp
+inline constexpr double kMaxExpandedPower = 4;
+
+// Узел графа выражения (DAG), в котором одинаковые поддеревья совпадают
+struct DagNode {
+    Type type;
+    std::uint32_t left;   // Первый операнд
+    std::uint32_t right;  // Второй операнд бинарного оператора
+    double value;         // Значение NUMBER или номер слота переменной X
+    std::uint32_t position;  // Позиция токена первого вхождения в выражении
+};
+
+struct DagKey {
+    Type type;
+    std::uint32_t left;
+    std::uint32_t right;
+    std::uint64_t bits;  // Битовое представление значения NUMBER или слота X
+
+    constexpr bool operator==(const DagKey&) const = default;
+};
+
+struct DagKeyHash {
+    constexpr std::size_t operator()(const DagKey& key) const {
+        std::uint64_t h = static_cast<std::uint64_t>(key.type);
+        h = h * 0x9E3779B97F4A7C15ULL ^ key.left;
+        h = h * 0x9E3779B97F4A7C15ULL ^ key.right;
+        h = h * 0x9E3779B97F4A7C15ULL ^ key.bits;
+        h = (h ^ (h >> 29)) * 0x9E3779B97F4A7C15ULL;
+        return static_cast<std::size_t>(h ^ (h >> 32));
+    }
+};
+
+// 1/c, если c - степень двойки и 1/c нормально, иначе 0. Проверка по битам:
+// frexp и isnormal не constexpr
+constexpr double exactReciprocal(double c) {
+    const std::uint64_t bits = std::bit_cast<std::uint64_t>(c);
+    const std::uint64_t exponent = (bits >> 52) & 0x7FF;
+    const std::uint64_t mantissa = bits & ((std::uint64_t{1} << 52) - 1);
+    const bool power_of_two =
+        (exponent >= 1 && exponent <= 2045 && mantissa == 0) || (exponent == 0 && mantissa == std::uint64_t{1} << 51);
+    return power_of_two ? 1 / c : 0;
+}
+
+// Граф выражения с упрощениями при построении. Построение и запись в
+// программу constexpr: тот же код оптимизирует SmartCalcModel::compile и
+// ct::compile, поэтому программы ct_expr и модели совпадают
+class ExpressionDag {
+public:
+    // Построение графа по программе; false, если программа некорректна
+    constexpr bool build(const std::vector<Instruction>& code, const std::vector<double>& constants,
+                         const std::vector<std::uint32_t>& positions);
+    // Запись графа обратно в программу в прежнем порядке вычисления
+    constexpr void emit(std::vector<Instruction>& code, std::vector<double>& constants,
+                        std::vector<std::uint32_t>& positions, std::size_t& temps) const;
+    // Замена корня его производной по переменной слота variable
+    void differentiate(std::uint32_t variable);
+
+private:
+    static constexpr DagKey key(Type type, std::uint32_t left, std::uint32_t right, double value) {
+        DagKey result{type, left, right,
+                      type == Type::NUMBER || type == Type::X ? std::bit_cast<std::uint64_t>(value) : 0};
+        // Сложение и умножение коммутативны: a+b и b+a дают один узел
+        if ((type == Type::PLUS || type == Type::MULT) && result.left > result.right) {
+            std::swap(result.left, result.right);
+        }
+        return result;
+    }
+
+    // Новые узлы получают позицию токена, из которого они построены
+    constexpr std::uint32_t intern(Type type, std::uint32_t left, std::uint32_t right, double value,
+                                   std::uint32_t position);
+    constexpr void rehash(std::size_t size);
+    constexpr std::uint32_t operation(Type type, std::uint32_t left, std::uint32_t right,
+                                      std::uint32_t position);
+    constexpr std::uint32_t power(std::uint32_t base, unsigned exponent, std::uint32_t position);
+    constexpr bool isNumber(std::uint32_t id) const { return nodes_[id].type == Type::NUMBER; }
+    constexpr bool isNumber(std::uint32_t id, double value) const {
+        return isNumber(id) && nodes_[id].value == value;
+    }
+    // Значение узла всегда +0, положительно или NaN (но не -0 и не отрицательно)
+    constexpr bool nonNegative(std::uint32_t id) const;
+
+    // Узлы производной с упрощениями: свертка чисел, a+0, a*1, a*0, -(-a)
+    std::uint32_t number(double value, std::uint32_t position);
+    std::uint32_t sum(std::uint32_t a, std::uint32_t b, std::uint32_t position);
+    std::uint32_t difference(std::uint32_t a, std::uint32_t b, std::uint32_t position);
+    std::uint32_t product(std::uint32_t a, std::uint32_t b, std::uint32_t position);
+    std::uint32_t quotient(std::uint32_t a, std::uint32_t b, std::uint32_t position);
+    std::uint32_t negate(std::uint32_t a, std::uint32_t position);
+    // Производная узла id по производным его операндов da и db
+    std::uint32_t derivative(std::uint32_t id, std::uint32_t da, std::uint32_t db);
+
+    std::vector<DagNode> nodes_;
+    // Индекс узлов с открытой адресацией: номер узла или kNoOperand;
+    // размер - степень двойки, заполнение не больше половины
+    std::vector<std::uint32_t> index_;
+    std::uint32_t root_ = kNoOperand;
+};
+
+// Поиск или добавление узла; одинаковые поддеревья получают один номер
+constexpr std::uint32_t ExpressionDag::intern(Type type, std::uint32_t left, std::uint32_t right, double value,
+                                              std::uint32_t position) {
+    if (2 * (nodes_.size() + 1) > index_.size()) rehash(index_.empty() ? 16 : 2 * index_.size());
+    const DagKey wanted = key(type, left, right, value);
+    const std::size_t mask = index_.size() - 1;
+    for (std::size_t slot = DagKeyHash{}(wanted) & mask;; slot = (slot + 1) & mask) {
+        const std::uint32_t id = index_[slot];
+        if (id == kNoOperand) {
+            index_[slot] = static_cast<std::uint32_t>(nodes_.size());
+            nodes_.push_back(DagNode{type, left, right, value, position});
+            return index_[slot];
+        }
+        const DagNode& node = nodes_[id];
+        if (key(node.type, node.left, node.right, node.value) == wanted) return id;
+    }
+}
+
+constexpr void ExpressionDag::rehash(std::size_t size) {
+    index_.assign(size, kNoOperand);
+    for (std::size_t id = 0; id < nodes_.size(); ++id) {
+        const DagNode& node = nodes_[id];
+        std::size_t slot = DagKeyHash{}(key(node.type, node.left, node.right, node.value)) & (size - 1);
+        while (index_[slot] != kNoOperand) slot = (slot + 1) & (size - 1);
+        index_[slot] = static_cast<std::uint32_t>(id);
+    }
+}
+
+// Понижение стоимости операций:
+//   a^1 -> a, a^n (n = 2..4) -> умножения с возведением в квадрат,
+//   a^0.5 -> sqrt(a), если a не бывает отрицательным и -0 (иначе менялись бы
+//     вид ошибки, NOT_FINITE вместо SQRT_DOMAIN, и знак нуля: pow(-0, 0.5) = +0);
+//     sqrt округляется правильно, поэтому расхождение с std::pow не больше 1 ulp,
+//   a/c -> a*(1/c), если c - степень двойки и 1/c точно представимо
+constexpr std::uint32_t ExpressionDag::operation(Type type, std::uint32_t left, std::uint32_t right,
+                                                 std::uint32_t position) {
+    if (right != kNoOperand && isNumber(right)) {
+        double c = nodes_[right].value;
+        if (type == Type::POW) {
+            if (c == 1) return left;
+            if (c == 0.5 && nonNegative(left)) return intern(Type::SQRT, left, kNoOperand, 0, position);
+            if (c >= 2 && c <= kMaxExpandedPower && c == static_cast<unsigned>(c)) {
+                return power(left, static_cast<unsigned>(c), position);
+            }
+        }
+        if (type == Type::DIV && exactReciprocal(c) != 0) {
+            std::uint32_t factor = intern(Type::NUMBER, kNoOperand, kNoOperand, exactReciprocal(c), position);
+            return intern(Type::MULT, left, factor, 0, position);
+        }
+    }
+    return intern(type, left, right, 0, position);
+}
+
+// Консервативная проверка по структуре: квадрат, сумма, произведение и частное
+// неотрицательных, корень и арккосинус неотрицательного аргумента
+constexpr bool ExpressionDag::nonNegative(std::uint32_t id) const {
+    const DagNode& node = nodes_[id];
+    switch (node.type) {
+        case Type::NUMBER:
+            return !std::signbit(node.value);
+        case Type::MULT:
+            return node.left == node.right || (nonNegative(node.left) && nonNegative(node.right));
+        case Type::PLUS:
+        case Type::DIV:
+            return nonNegative(node.left) && nonNegative(node.right);
+        case Type::SQRT:
+            return nonNegative(node.left);
+        case Type::ACOS:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Степень с натуральным показателем через повторное возведение в квадрат
+constexpr std::uint32_t ExpressionDag::power(std::uint32_t base, unsigned exponent, std::uint32_t position) {
+    std::uint32_t result = kNoOperand;
+    while (true) {
+        if (exponent & 1) {
+            result = result == kNoOperand ? base : intern(Type::MULT, result, base, 0, position);
+        }
+        exponent >>= 1;
+        if (!exponent) return result;
+        base = intern(Type::MULT, base, base, 0, position);
+    }
+}
+
+constexpr bool ExpressionDag::build(const std::vector<Instruction>& code, const std::vector<double>& constants,
+                                    const std::vector<std::uint32_t>& positions) {
+    std::vector<std::uint32_t> stack;
+    std::vector<std::uint32_t> temps;
+    nodes_.reserve(code.size());
+    for (std::size_t i = 0; i < code.size(); ++i) {
+        const Instruction& ins = code[i];
+        int operands = operandCount(ins.type);
+        if (operands < 0 || stack.size() < static_cast<std::size_t>(operands)) return false;
+        // Временные значения общих подвыражений снова становятся общими узлами
+        if (ins.type == Type::STORE) {
+            if (temps.size() <= ins.operand) temps.resize(ins.operand + 1, kNoOperand);
+            temps[ins.operand] = stack.back();
+            continue;
+        }
+        if (ins.type == Type::LOAD) {
+            if (ins.operand >= temps.size() || temps[ins.operand] == kNoOperand) return false;
+            stack.push_back(temps[ins.operand]);
+            continue;
+        }
+        std::uint32_t left = kNoOperand, right = kNoOperand;
+        if (operands == 2) {
+            right = stack.back();
+            stack.pop_back();
+        }
+        if (operands >= 1) {
+            left = stack.back();
+            stack.pop_back();
+        }
+        if (ins.type == Type::NUMBER) {
+            stack.push_back(intern(Type::NUMBER, kNoOperand, kNoOperand, constants[ins.operand], positions[i]));
+        } else if (ins.type == Type::X) {
+            stack.push_back(intern(Type::X, kNoOperand, kNoOperand, ins.operand, positions[i]));
+        } else if (operands == 0) {
+            stack.push_back(intern(ins.type, kNoOperand, kNoOperand, 0, positions[i]));
+        } else {
+            stack.push_back(operation(ins.type, left, right, positions[i]));
+        }
+    }
+    if (stack.size() != 1) return false;
+    root_ = stack.back();
+    return true;
+}
+
+constexpr void ExpressionDag::emit(std::vector<Instruction>& code, std::vector<double>& constants,
+                                   std::vector<std::uint32_t>& positions, std::size_t& temps) const {
+    // Число использований достижимых узлов; операнды всегда созданы раньше
+    // родителя, поэтому достаточно одного прохода от конца
+    std::vector<std::uint32_t> uses(nodes_.size(), 0);
+    uses[root_] = 1;
+    for (std::size_t id = nodes_.size(); id-- > 0;) {
+        if (!uses[id]) continue;
+        if (nodes_[id].left != kNoOperand) ++uses[nodes_[id].left];
+        if (nodes_[id].right != kNoOperand) ++uses[nodes_[id].right];
+    }
+
+    // Обход без рекурсии: операнды выписываются слева направо, как в исходной RPN
+    code.clear();
+    constants.clear();
+    positions.clear();
+    temps = 0;
+    std::vector<std::uint32_t> slots(nodes_.size(), kNoOperand);
+    std::vector<std::pair<std::uint32_t, bool>> frames{{root_, false}};
+    while (!frames.empty()) {
+        auto [id, expanded] = frames.back();
+        frames.pop_back();
+        const DagNode& node = nodes_[id];
+        if (expanded) {
+            code.push_back(Instruction{node.type, 0});
+            positions.push_back(node.position);
+            if (uses[id] > 1) {
+                slots[id] = static_cast<std::uint32_t>(temps++);
+                code.push_back(Instruction{Type::STORE, slots[id]});
+                positions.push_back(node.position);
+            }
+        } else if (slots[id] != kNoOperand) {
+            code.push_back(Instruction{Type::LOAD, slots[id]});
+            positions.push_back(node.position);
+        } else if (node.type == Type::NUMBER) {
+            code.push_back(Instruction{Type::NUMBER, static_cast<std::uint32_t>(constants.size())});
+            positions.push_back(node.position);
+            constants.push_back(node.value);
+        } else if (node.type == Type::X) {
+            code.push_back(Instruction{Type::X, static_cast<std::uint32_t>(node.value)});
+            positions.push_back(node.position);
+        } else if (operandCount(node.type) == 0) {
+            code.push_back(Instruction{node.type, 0});
+            positions.push_back(node.position);
+        } else {
+            frames.emplace_back(id, true);
+            if (node.right != kNoOperand) frames.emplace_back(node.right, false);
+            frames.emplace_back(node.left, false);
+        }
+    }
+}
+
+}  // namespace s21
+
+#endif  // SMARTCALC_DAG_H
@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <new>
+#include <numbers>
+#include <stdexcept>
+
+#include "smartcalc_model.h"
+
+namespace s21 {
+
+namespace {
+
+// Производная результата операции по ее операндам (правила дифференцирования).
+// value - уже вычисленное значение операции
+double derivative(Type type, const Dual& a, const Dual& b, double value) {
+    switch (type) {
+        case Type::PLUS:
+            return a.derivative + b.derivative;
+        case Type::MINUS:
+            return a.derivative - b.derivative;
+        case Type::MULT:
+            return a.derivative * b.value + a.value * b.derivative;
+        case Type::DIV:
+            return (a.derivative * b.value - a.value * b.derivative) / (b.value * b.value);
+        case Type::POW: {
+            // (a^b)' = b a^(b-1) a' + a^b ln(a) b'; слагаемые с нулевым
+            // множителем пропускаются, чтобы не получить 0 * inf
+            double d = 0;
+            if (a.derivative != 0) d += b.value * std::pow(a.value, b.value - 1) * a.derivative;
+            if (b.derivative != 0) d += value * std::log(a.value) * b.derivative;
+            return d;
+        }
+        case Type::MOD:
+            // fmod(a, b) = a - trunc(a / b) * b
+            return a.derivative - std::trunc(a.value / b.value) * b.derivative;
+        case Type::SIN:
+            return std::cos(a.value) * a.derivative;
+        case Type::COS:
+            return -std::sin(a.value) * a.derivative;
+        case Type::TAN:
+            return (1 + value * value) * a.derivative;
+        case Type::COT:
+            return -(1 + value * value) * a.derivative;
+        case Type::ASIN:
+            return a.derivative / std::sqrt(1 - a.value * a.value);
+        case Type::ACOS:
+            return -a.derivative / std::sqrt(1 - a.value * a.value);
+        case Type::ATAN:
+            return a.derivative / (1 + a.value * a.value);
+        case Type::SQRT:
+            return a.derivative / (2 * value);
+        case Type::LOG:
+            return a.derivative / (a.value * std::numbers::ln10);
+        case Type::LN:
+            return a.derivative / a.value;
+        case Type::UNARY_MINUS:
+            return -a.derivative;
+        default:
+            return 0;
+    }
+}
+
+}  // namespace
+
+Dual CompiledExpression::evaluateDerivative(double x_value) const {
+    return evaluateDerivative(std::span<const double>(&x_value, 1), 0);
+}
+
+Dual CompiledExpression::evaluateDerivative(std::span<const double> bindings,
+                                            std::size_t variable) const {
+    Dual result{};
+    EvalError error = tryEvaluateDerivative(bindings, variable, result);
+    if (error.kind != ErrorKind::NONE) throw std::invalid_argument(errorMessage(error.kind));
+    return result;
+}
+
+EvalError CompiledExpression::tryEvaluateDerivative(double x_value, Dual& result) const noexcept {
+    return tryEvaluateDerivative(std::span<const double>(&x_value, 1), 0, result);
+}
+
+EvalError CompiledExpression::tryEvaluateDerivative(std::span<const double> bindings, std::size_t variable,
+                                                    Dual& result) const noexcept {
+    constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+    result = Dual{0, 0};
+    if (code_.empty()) return EvalError{ErrorKind::NONE, 0};
+    EvalError error{ErrorKind::BINDING_SIZE, 0};
+    if (bindings.size() >= variables_) {
+        const std::size_t size = temps_ + depth_;
+        std::array<Dual, kInlineStackSize> inline_stack;
+        try {
+            error = calcDual(bindings.data(), variable,
+                             size <= inline_stack.size() ? inline_stack.data() : scratch<Dual>(size), result);
+        } catch (const std::bad_alloc&) {
+            // Буфер стека потока не удалось увеличить
+            error = EvalError{ErrorKind::OUT_OF_MEMORY, 0};
+        }
+    }
+    if (error.kind != ErrorKind::NONE) result = Dual{kNaN, kNaN};
+    return error;
+}
+
+void CompiledExpression::evaluateDerivative(std::span<const double> x_values, std::span<double> values,
+                                            std::span<double> derivatives, std::span<std::uint8_t> valid,
+                                            std::size_t variable) const {
+    checkBatch(x_values.size(), values.size(), valid.size(), 0);
+    if (derivatives.size() != values.size()) throw std::invalid_argument(errorMessage(ErrorKind::BATCH_SIZE));
+    // Буфер стека потока, как у пакетного вычисления значений
+    Dual* stack = scratch<Dual>(std::max<std::size_t>(temps_ + depth_, 1));
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        Dual result{0, 0};
+        EvalError error{ErrorKind::NONE, 0};
+        if (!code_.empty()) error = calcDual(x_values.data() + i * variables_, variable, stack, result);
+        if (error.kind != ErrorKind::NONE) {
+            result = Dual{std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN()};
+        }
+        values[i] = result.value;
+        derivatives[i] = result.derivative;
+        if (!valid.empty()) valid[i] = error.kind == ErrorKind::NONE ? 1 : 0;
+    }
+}
+
+// Вычисление над дуальными числами: та же программа, что в calcExpression,
+// значения считаются теми же функциями, поэтому совпадают с evaluate побитово
+EvalError CompiledExpression::calcDual(const double* bindings, std::size_t variable, Dual* stack,
+                                       Dual& result) const noexcept {
+    Dual* top = stack + temps_;  // Первая свободная ячейка
+    ErrorKind error = ErrorKind::NONE;
+    for (std::size_t i = 0; i < code_.size(); ++i) {
+        const Instruction& ins = code_[i];
+        switch (operandCount(ins.type)) {
+            case 0:
+                if (ins.type == Type::X) *top++ = Dual{bindings[ins.operand], ins.operand == variable ? 1.0 : 0.0};
+                else if (ins.type == Type::LOAD) *top++ = stack[ins.operand];
+                else *top++ = Dual{constants_[ins.operand], 0};
+                break;
+
+            case 1:
+                if (ins.type == Type::STORE) {
+                    stack[ins.operand] = top[-1];
+                } else {
+                    double value = trigonometry(top[-1].value, ins.type, error);
+                    top[-1] = Dual{value, derivative(ins.type, top[-1], Dual{0, 0}, value)};
+                }
+                break;
+
+            case 2: {
+                --top;
+                double value = arithmetic(top[-1].value, top->value, ins.type, error);
+                top[-1] = Dual{value, derivative(ins.type, top[-1], *top, value)};
+                break;
+            }
+
+            default:
+                error = ErrorKind::UNKNOWN_OPERATOR;
+        }
+        if (error != ErrorKind::NONE) return EvalError{error, positions_[i]};
+    }
+
+    result = stack[temps_];
+    if (!std::isfinite(result.value)) return EvalError{ErrorKind::NOT_FINITE, positions_.back()};
+    return EvalError{ErrorKind::NONE, 0};
+}
+
+}  // namespace s21
@@ -0,0 +1,173 @@
+#include "smartcalc_integrator.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace s21 {
+
+namespace {
+
+// Узлы и веса правила Кронрода 21 точки (QUADPACK qk21): узлы с нечетными
+// номерами вместе с центром образуют правило Гаусса 10 точек
+constexpr std::array<double, 11> kNodes = {
+    0.995657163025808080735527280689003, 0.973906528517171720077964012084452,
+    0.930157491355708226001207180059508, 0.865063366688984510732096688423493,
+    0.780817726586416897063717578345042, 0.679409568299024406234327365114874,
+    0.562757134668604683339000099272694, 0.433395394129247190799265943165784,
+    0.294392862701460198131126603103866, 0.148874338981631210884826001129720,
+    0.0};
+constexpr std::array<double, 11> kKronrodWeights = {
+    0.011694638867371874278064396062192, 0.032558162307964727478818972459390,
+    0.054755896574351996031381300244580, 0.075039674810919952767043140916190,
+    0.093125454583697605535065465083366, 0.109387158802297641899210590325805,
+    0.123491976262065851077208980221355, 0.134709217311473325928054001771707,
+    0.142775938577060080797094273138717, 0.147739104901338491374841515972068,
+    0.149445554002916905664936468389821};
+constexpr std::array<double, 5> kGaussWeights = {
+    0.066671344308688137593568809893332, 0.149451349150580593145776339657697,
+    0.219086362515982043995534934228163, 0.269266719309996355091226921569469,
+    0.295524224714752870173892994651958};
+
+constexpr std::size_t kPoints = 21;  // Вычислений на подотрезок
+
+struct Segment {
+    double a, b;
+    double value;  // Оценка Кронрода
+    double error;  // |Кронрод - Гаусс|
+};
+
+// Узлы подотрезка [a, b] в порядке: пары +-kNodes[k], затем центр
+void segmentNodes(double a, double b, double* x) {
+    const double center = (a + b) / 2, half = (b - a) / 2;
+    for (std::size_t k = 0; k < 10; ++k) {
+        x[2 * k] = center - half * kNodes[k];
+        x[2 * k + 1] = center + half * kNodes[k];
+    }
+    x[20] = center;
+}
+
+void estimate(Segment& segment, const double* f) {
+    const double half = (segment.b - segment.a) / 2;
+    double kronrod = kKronrodWeights[10] * f[20], gauss = 0;
+    for (std::size_t k = 0; k < 10; ++k) {
+        const double pair = f[2 * k] + f[2 * k + 1];
+        kronrod += kKronrodWeights[k] * pair;
+        if (k % 2 == 1) gauss += kGaussWeights[k / 2] * pair;
+    }
+    segment.value = kronrod * half;
+    segment.error = std::abs((kronrod - gauss) * half);
+}
+
+}  // namespace
+
+Integrator::Integrator(IntegrationOptions options, ThreadPool& pool) : options_(options), pool_(pool) {}
+
+IntegrationResult Integrator::integrate(const CompiledExpression& function, double a, double b) const {
+    if (function.variables() != 1) throw std::invalid_argument("Integrand must be a single-variable expression.");
+    if (!std::isfinite(a) || !std::isfinite(b)) throw std::invalid_argument("Invalid integration interval.");
+    if (a == b) return IntegrationResult{0, 0, 0, 0, true};
+    if (a > b) {
+        IntegrationResult result = integrate(function, b, a);
+        result.value = -result.value;
+        return result;
+    }
+
+    // Начальное разбиение задано параметрами и ограничено бюджетом; размер пула
+    // влияет только на размер отрезков параллельного вычисления
+    const std::size_t budget = std::max(options_.max_evaluations, kPoints);
+    const std::size_t initial = std::clamp<std::size_t>(options_.initial_intervals, 1, budget / kPoints);
+    std::vector<Segment> segments(initial);
+    for (std::size_t i = 0; i < initial; ++i) {
+        segments[i].a = i == 0 ? a : a + (b - a) * i / initial;
+        segments[i].b = i + 1 == initial ? b : a + (b - a) * (i + 1) / initial;
+    }
+    std::vector<std::size_t> pending(initial);  // Подотрезки без оценки
+    std::iota(pending.begin(), pending.end(), 0);
+
+    IntegrationResult result{0, 0, 0, 0, false};
+    std::vector<double> xs, fs;
+    std::vector<std::uint8_t> valid;
+    while (true) {
+        // Узлы всех новых подотрезков - один параллельный пакет
+        xs.resize(pending.size() * kPoints);
+        fs.resize(xs.size());
+        valid.resize(xs.size());
+        for (std::size_t i = 0; i < pending.size(); ++i) {
+            segmentNodes(segments[pending[i]].a, segments[pending[i]].b, xs.data() + i * kPoints);
+        }
+        function.evaluateParallel(xs, fs, valid, std::max<std::size_t>(kPoints * 16, xs.size() / (4 * pool_.size())),
+                                  pool_);
+        result.evaluations += xs.size();
+        if (std::find(valid.begin(), valid.end(), 0) != valid.end()) {
+            throw std::invalid_argument("Integrand is undefined on the interval.");
+        }
+        for (std::size_t i = 0; i < pending.size(); ++i) estimate(segments[pending[i]], fs.data() + i * kPoints);
+
+        // Сумма по порядку подотрезков
+        result.value = 0;
+        result.error = 0;
+        for (const Segment& segment : segments) {
+            result.value += segment.value;
+            result.error += segment.error;
+        }
+        const double tolerance = std::max(options_.absolute_tolerance, options_.relative_tolerance * std::abs(result.value));
+        if (result.error <= tolerance) {
+            result.converged = true;
+            break;
+        }
+
+        // Делятся подотрезки с погрешностью больше их доли допуска; при нехватке
+        // бюджета - только худшие (при равенстве - левые)
+        std::vector<std::size_t> split;
+        for (std::size_t i = 0; i < segments.size(); ++i) {
+            const Segment& segment = segments[i];
+            if (segment.error > tolerance * (segment.b - segment.a) / (b - a)) split.push_back(i);
+        }
+        const std::size_t affordable = (budget - result.evaluations) / (2 * kPoints);
+        if (affordable == 0) break;
+        if (split.size() > affordable) {
+            std::stable_sort(split.begin(), split.end(), [&segments](std::size_t l, std::size_t r) {
+                return segments[l].error > segments[r].error;
+            });
+            split.resize(affordable);
+            std::sort(split.begin(), split.end());
+        }
+        // Подотрезок слишком мал для деления в double
+        split.erase(std::remove_if(split.begin(), split.end(),
+                                   [&segments](std::size_t i) {
+                                       const Segment& s = segments[i];
+                                       double middle = (s.a + s.b) / 2;
+                                       return middle <= s.a || middle >= s.b;
+                                   }),
+                    split.end());
+        if (split.empty()) break;
+
+        // Новое разбиение по возрастанию x: каждый делимый отрезок дает два
+        std::vector<Segment> next;
+        next.reserve(segments.size() + split.size());
+        pending.clear();
+        std::size_t s = 0;
+        for (std::size_t i = 0; i < segments.size(); ++i) {
+            if (s < split.size() && split[s] == i) {
+                ++s;
+                const double middle = (segments[i].a + segments[i].b) / 2;
+                pending.push_back(next.size());
+                next.push_back(Segment{segments[i].a, middle, 0, 0});
+                pending.push_back(next.size());
+                next.push_back(Segment{middle, segments[i].b, 0, 0});
+            } else {
+                next.push_back(segments[i]);
+            }
+        }
+        segments = std::move(next);
+    }
+    result.intervals = segments.size();
+    return result;
+}
+
+}  // namespace s21
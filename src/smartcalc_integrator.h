@@ -0,0 +1,49 @@
+#ifndef SMARTCALC_INTEGRATOR_H
+#define SMARTCALC_INTEGRATOR_H
+
+#include <cstddef>
+
+#include "smartcalc_model.h"
+#include "smartcalc_thread_pool.h"
+
+namespace s21 {
+
+// Параметры численного интегрирования
+struct IntegrationOptions {
+    double absolute_tolerance = 1e-10;
+    double relative_tolerance = 1e-10;
+    std::size_t max_evaluations = 1u << 20;  // Бюджет вычислений подынтегральной функции
+    // Подотрезков в начальном разбиении. Не зависит от пула: иначе от числа
+    // потоков зависело бы итоговое разбиение, а с ним и последние биты результата
+    std::size_t initial_intervals = 16;
+};
+
+struct IntegrationResult {
+    double value;
+    double error;             // Оценка абсолютной погрешности
+    std::size_t evaluations;  // Вычислений функции
+    std::size_t intervals;    // Подотрезков в итоговом разбиении
+    bool converged;           // Точность достигнута в пределах бюджета
+};
+
+// Адаптивное интегрирование по Гауссу-Кронроду (21 точка на подотрезок).
+// На каждом шаге делятся пополам все подотрезки, чья погрешность больше их
+// доли допуска; узлы всех новых подотрезков вычисляются одним параллельным
+// пакетом на пуле потоков. Подотрезки хранятся по возрастанию x и суммируются
+// в этом порядке, а разбиение определяется только параметрами, поэтому
+// результат побитово одинаков при любом числе потоков
+class Integrator {
+public:
+    explicit Integrator(IntegrationOptions options = {}, ThreadPool& pool = ThreadPool::instance());
+
+    // Интеграл от a до b; исключение, если функция не определена в узле
+    IntegrationResult integrate(const CompiledExpression& function, double a, double b) const;
+
+private:
+    IntegrationOptions options_;
+    ThreadPool& pool_;
+};
+
+}  // namespace s21
+
+#endif  // SMARTCALC_INTEGRATOR_H
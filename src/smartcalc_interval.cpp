@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <stdexcept>
+#include <vector>
+
+#include "smartcalc_model.h"
+
+namespace s21 {
+
+namespace {
+
+constexpr double kInf = std::numeric_limits<double>::infinity();
+constexpr Interval kEmpty{kInf, -kInf};
+constexpr Interval kEntire{-kInf, kInf};
+// Запас при поиске экстремумов периодических функций: точка вблизи границы
+// считается попавшей в отрезок, это только расширяет оценку
+constexpr double kPeriodSlack = 1e-9;
+// Дальше этого аргумента период не различим в double
+constexpr double kPeriodLimit = 1e15;
+
+// Граница сдвигается наружу на один ulp: это покрывает ошибку округления
+// операций и функций libm. NaN (например, inf - inf) дает бесконечность
+double down(double v) { return std::isnan(v) ? -kInf : std::nextafter(v, -kInf); }
+double up(double v) { return std::isnan(v) ? kInf : std::nextafter(v, kInf); }
+
+Interval outward(double lo, double hi) { return Interval{down(lo), up(hi)}; }
+
+// Произведение с 0 * inf = 0: бесконечная граница лишь оценивает сверху конечные значения
+double product(double a, double b) { return a == 0 || b == 0 ? 0 : a * b; }
+
+Interval multiply(const Interval& a, const Interval& b) {
+    double p[] = {product(a.lo, b.lo), product(a.lo, b.hi), product(a.hi, b.lo), product(a.hi, b.hi)};
+    return outward(*std::min_element(p, p + 4), *std::max_element(p, p + 4));
+}
+
+// Множество значений |x|
+Interval magnitude(const Interval& a) {
+    double hi = std::max(std::abs(a.lo), std::abs(a.hi));
+    return Interval{a.contains(0) ? 0 : std::min(std::abs(a.lo), std::abs(a.hi)), hi};
+}
+
+Interval square(const Interval& a) {
+    Interval m = magnitude(a);
+    return Interval{m.lo == 0 ? 0 : down(m.lo * m.lo), up(m.hi * m.hi)};
+}
+
+// Обратная величина; partial отмечает ноль в знаменателе
+Interval reciprocal(const Interval& b, bool& partial) {
+    if (b.lo == 0 && b.hi == 0) {
+        partial = true;
+        return kEmpty;
+    }
+    if (b.lo < 0 && b.hi > 0) {
+        partial = true;
+        return kEntire;
+    }
+    if (b.lo == 0) {
+        partial = true;
+        return Interval{down(1 / b.hi), kInf};
+    }
+    if (b.hi == 0) {
+        partial = true;
+        return Interval{-kInf, up(1 / b.lo)};
+    }
+    return outward(1 / b.hi, 1 / b.lo);
+}
+
+// Есть ли в отрезке точка phase + k * period
+bool hits(const Interval& a, double phase, double period) {
+    return std::floor((a.hi - phase) / period + kPeriodSlack) >=
+           std::ceil((a.lo - phase) / period - kPeriodSlack);
+}
+
+// sin и cos: значения на концах плюс экстремумы внутри отрезка
+Interval periodic(const Interval& a, double (*function)(double), double max_phase, double min_phase) {
+    constexpr double kPeriod = 2 * std::numbers::pi;
+    if (a.width() >= kPeriod || std::abs(a.lo) > kPeriodLimit || std::abs(a.hi) > kPeriodLimit) {
+        return Interval{-1, 1};
+    }
+    double f_lo = function(a.lo), f_hi = function(a.hi);
+    double lo = hits(a, min_phase, kPeriod) ? -1 : std::max(-1.0, down(std::min(f_lo, f_hi)));
+    double hi = hits(a, max_phase, kPeriod) ? 1 : std::min(1.0, up(std::max(f_lo, f_hi)));
+    return Interval{lo, hi};
+}
+
+Interval tangent(const Interval& a) {
+    constexpr double kHalfPi = std::numbers::pi / 2;
+    if (a.width() >= std::numbers::pi || std::abs(a.lo) > kPeriodLimit ||
+        std::abs(a.hi) > kPeriodLimit || hits(a, kHalfPi, std::numbers::pi)) {
+        return kEntire;
+    }
+    return outward(std::tan(a.lo), std::tan(a.hi));
+}
+
+// Пересечение с областью определения [lo, hi] функции; partial, если отрезок шире нее
+Interval restrict(const Interval& a, double lo, double hi, bool& partial) {
+    if (a.lo < lo || a.hi > hi) partial = true;
+    return Interval{std::max(a.lo, lo), std::min(a.hi, hi)};
+}
+
+Interval power(const Interval& a, const Interval& b, bool& partial) {
+    // Целый показатель: знак основания не важен, функция монотонна на участках.
+    // Четность дает fmod; все double от 2^53 четные
+    if (b.lo == b.hi && std::isfinite(b.lo) && b.lo == std::nearbyint(b.lo)) {
+        double n = b.lo;
+        if (n == 0) return Interval{1, 1};
+        Interval base = a;
+        if (n < 0) {
+            base = reciprocal(a, partial);
+            if (base.empty()) return kEmpty;
+            n = -n;
+        }
+        if (std::fmod(n, 2) == 0) {
+            Interval m = magnitude(base);
+            return outward(std::pow(m.lo, n), std::pow(m.hi, n));
+        }
+        return outward(std::pow(base.lo, n), std::pow(base.hi, n));
+    }
+    // Дробный показатель: отрицательные основания дают NaN
+    Interval base = a;
+    if (base.lo < 0) {
+        partial = true;
+        base.lo = 0;
+        if (base.hi < 0) {
+            if (b.lo == b.hi) return kEmpty;
+            // Определены лишь целые показатели из отрезка; модуль не больше |a|^b
+            Interval m = magnitude(a);
+            double p[] = {std::pow(m.lo, b.lo), std::pow(m.lo, b.hi), std::pow(m.hi, b.lo),
+                          std::pow(m.hi, b.hi)};
+            double bound = up(*std::max_element(p, p + 4));
+            return Interval{-bound, bound};
+        }
+    }
+    if (base.lo == 0 && b.lo < 0) partial = true;
+    // x^y монотонна по каждому аргументу при x >= 0: экстремумы в углах
+    double p[] = {std::pow(base.lo, b.lo), std::pow(base.lo, b.hi), std::pow(base.hi, b.lo),
+                  std::pow(base.hi, b.hi)};
+    Interval result = outward(*std::min_element(p, p + 4), *std::max_element(p, p + 4));
+    if (a.lo < 0) {
+        // Целые показатели при отрицательном основании дают значения обоих знаков
+        double m = magnitude(a).hi;
+        double bound = std::max({std::abs(result.lo), std::abs(result.hi),
+                                 up(std::pow(m, b.lo)), up(std::pow(m, b.hi))});
+        result = Interval{-bound, bound};
+    }
+    return result;
+}
+
+Interval modulo(const Interval& a, const Interval& b, bool& partial) {
+    if (b.lo == 0 && b.hi == 0) {
+        partial = true;
+        return kEmpty;
+    }
+    if (b.contains(0)) partial = true;
+    // Внутри одного периода fmod монотонна
+    if (b.lo == b.hi && std::isfinite(b.lo)) {
+        // Деление может округлиться через границу периода: тогда концы
+        // окажутся не по порядку и сработает общая оценка
+        double period = std::abs(b.lo);
+        bool one_period = (a.lo >= 0 && std::floor(a.lo / period) == std::floor(a.hi / period)) ||
+                          (a.hi <= 0 && std::ceil(a.lo / period) == std::ceil(a.hi / period));
+        Interval r{std::fmod(a.lo, period), std::fmod(a.hi, period)};
+        if (one_period && std::isfinite(a.lo) && std::isfinite(a.hi) && r.lo <= r.hi) return r;
+    }
+    // |fmod(a, b)| < |b|, знак результата совпадает со знаком a
+    double bound = std::max(std::abs(b.lo), std::abs(b.hi));
+    return Interval{a.lo >= 0 ? 0 : std::max(a.lo, -bound), a.hi <= 0 ? 0 : std::min(a.hi, bound)};
+}
+
+// Монотонная функция на отрезке
+Interval increasing(const Interval& a, double (*function)(double)) {
+    return outward(function(a.lo), function(a.hi));
+}
+
+// Значение стека интервального вычисления. source - откуда взято значение
+// (переменная или временное); одинаковый source означает одно и то же число,
+// что позволяет считать x*x как квадрат, а не как произведение независимых
+struct IntervalValue {
+    Interval range;
+    std::uint32_t source;  // 0 - неизвестно
+};
+
+constexpr std::uint32_t kTempSource = 1u << 31;
+
+}  // namespace
+
+IntervalResult CompiledExpression::evaluateInterval(Interval x_range) const {
+    return evaluateInterval(std::span<const Interval>(&x_range, 1));
+}
+
+IntervalResult CompiledExpression::evaluateInterval(std::span<const Interval> bindings) const {
+    if (code_.empty()) return IntervalResult{Interval{0, 0}, true, true};
+    if (bindings.size() < variables_) throw std::invalid_argument(errorMessage(ErrorKind::BINDING_SIZE));
+
+    std::array<IntervalValue, kInlineStackSize> inline_stack;
+    std::vector<IntervalValue> heap_stack;
+    const std::size_t size = temps_ + depth_;
+    if (size > inline_stack.size()) heap_stack.resize(size);
+    IntervalValue* stack = size > inline_stack.size() ? heap_stack.data() : inline_stack.data();
+    IntervalValue* top = stack + temps_;
+    bool partial = false;  // Часть точек может дать ошибку области определения
+
+    for (const Instruction& ins : code_) {
+        switch (ins.type) {
+            case Type::NUMBER:
+                *top++ = {Interval{constants_[ins.operand], constants_[ins.operand]}, 0};
+                continue;
+            case Type::X:
+                *top++ = {bindings[ins.operand], ins.operand + 1};
+                continue;
+            case Type::LOAD:
+                *top++ = stack[ins.operand];
+                continue;
+            case Type::STORE:
+                top[-1].source = kTempSource | ins.operand;
+                stack[ins.operand] = top[-1];
+                continue;
+            default:
+                break;
+        }
+
+        const bool binary = operandCount(ins.type) == 2;
+        if (binary) --top;
+        IntervalValue& target = top[-1];
+        const Interval a = target.range;
+        const Interval b = binary ? top->range : Interval{0, 0};
+        const bool same = binary && target.source != 0 && target.source == top->source;
+        target.source = 0;
+        if (a.empty() || b.empty()) {
+            target.range = kEmpty;
+            continue;
+        }
+
+        Interval& r = target.range;
+        switch (ins.type) {
+            case Type::PLUS:
+                r = outward(a.lo + b.lo, a.hi + b.hi);
+                break;
+            case Type::MINUS:
+                r = same ? Interval{0, 0} : outward(a.lo - b.hi, a.hi - b.lo);
+                break;
+            case Type::MULT:
+                r = same ? square(a) : multiply(a, b);
+                break;
+            case Type::DIV: {
+                Interval inverse = reciprocal(b, partial);
+                r = inverse.empty() ? kEmpty : multiply(a, inverse);
+                break;
+            }
+            case Type::POW:
+                r = power(a, b, partial);
+                break;
+            case Type::MOD:
+                r = modulo(a, b, partial);
+                break;
+            case Type::UNARY_MINUS:
+                r = Interval{-a.hi, -a.lo};
+                break;
+            case Type::SIN:
+                r = periodic(a, [](double v) { return std::sin(v); }, std::numbers::pi / 2, -std::numbers::pi / 2);
+                break;
+            case Type::COS:
+                r = periodic(a, [](double v) { return std::cos(v); }, 0, std::numbers::pi);
+                break;
+            case Type::TAN:
+                r = tangent(a);
+                break;
+            case Type::COT:
+                r = reciprocal(tangent(a), partial);
+                break;
+            case Type::ASIN:
+            case Type::ACOS: {
+                Interval domain = restrict(a, -1, 1, partial);
+                if (domain.empty()) {
+                    r = kEmpty;
+                } else if (ins.type == Type::ASIN) {
+                    r = increasing(domain, [](double v) { return std::asin(v); });
+                } else {
+                    r = outward(std::acos(domain.hi), std::acos(domain.lo));
+                }
+                break;
+            }
+            case Type::ATAN:
+                r = increasing(a, [](double v) { return std::atan(v); });
+                break;
+            case Type::SQRT: {
+                Interval domain = restrict(a, 0, kInf, partial);
+                r = domain.empty() ? kEmpty : Interval{std::max(0.0, down(std::sqrt(domain.lo))), up(std::sqrt(domain.hi))};
+                break;
+            }
+            case Type::LOG:
+            case Type::LN: {
+                if (a.hi <= 0) {
+                    partial = true;
+                    r = kEmpty;
+                    break;
+                }
+                double (*function)(double) = ins.type == Type::LOG ? +[](double v) { return std::log10(v); }
+                                                                   : +[](double v) { return std::log(v); };
+                if (a.lo <= 0) partial = true;
+                r = Interval{a.lo <= 0 ? -kInf : down(function(a.lo)), up(function(a.hi))};
+                break;
+            }
+            default:
+                throw std::invalid_argument(errorMessage(ErrorKind::UNKNOWN_OPERATOR));
+        }
+        // Бесконечная граница - не значение, а лишь оценка: конечность не гарантирована
+        if (!r.empty() && (std::isinf(r.lo) || std::isinf(r.hi))) partial = true;
+    }
+
+    const Interval range = stack[temps_].range;
+    const bool defined = !range.empty();
+    return IntervalResult{range, defined, defined && !partial && std::isfinite(range.lo) && std::isfinite(range.hi)};
+}
+
+}  // namespace s21
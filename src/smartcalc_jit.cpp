@@ -0,0 +1,612 @@
+#include "smartcalc_jit.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <initializer_list>
+
+#include "smartcalc_simd.h"
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#include <sys/mman.h>
+#include <unistd.h>
+#define S21_JIT_X86_64 1
+#endif
+
+namespace s21 {
+
+#ifdef S21_JIT_X86_64
+
+namespace {
+
+// Обертки над libm с известным соглашением о вызовах: скаляр в xmm0 (и xmm1)
+double jitSin(double a) { return std::sin(a); }
+double jitCos(double a) { return std::cos(a); }
+double jitTan(double a) { return std::tan(a); }
+double jitAsin(double a) { return std::asin(a); }
+double jitAcos(double a) { return std::acos(a); }
+double jitAtan(double a) { return std::atan(a); }
+double jitLog(double a) { return std::log10(a); }
+double jitLn(double a) { return std::log(a); }
+double jitPow(double a, double b) { return std::pow(a, b); }
+double jitFmod(double a, double b) { return std::fmod(a, b); }
+
+// Векторные обертки: 4 точки по адресу в rdi (и rsi)
+template <double (*Function)(double)>
+void jitVector(double* a) {
+    for (int i = 0; i < 4; ++i) a[i] = Function(a[i]);
+}
+
+template <double (*Function)(double, double)>
+void jitVector2(double* a, const double* b) {
+    for (int i = 0; i < 4; ++i) a[i] = Function(a[i], b[i]);
+}
+
+// Ядра simd для функций, которые интерпретатор блоков тоже считает ими:
+// результаты машинного кода и интерпретатора совпадают побитово
+template <Type Op>
+void jitElementary(double* a) {
+    simd::unary(Op, a, a, 4);
+}
+
+void jitElementaryPow(double* a, const double* b) {
+    simd::binary(Type::POW, a, b, a, 4);
+}
+
+using UnaryFunction = double (*)(double);
+
+UnaryFunction scalarFunction(Type type) {
+    switch (type) {
+        case Type::SIN: return jitSin;
+        case Type::COS: return jitCos;
+        case Type::TAN:
+        case Type::COT: return jitTan;
+        case Type::ASIN: return jitAsin;
+        case Type::ACOS: return jitAcos;
+        case Type::ATAN: return jitAtan;
+        case Type::LOG: return jitLog;
+        case Type::LN: return jitLn;
+        default: return nullptr;
+    }
+}
+
+using VectorFunction = void (*)(double*);
+
+VectorFunction vectorFunction(Type type) {
+    switch (type) {
+        case Type::SIN: return jitElementary<Type::SIN>;
+        case Type::COS: return jitElementary<Type::COS>;
+        case Type::TAN:
+        case Type::COT: return jitVector<jitTan>;
+        case Type::ASIN: return jitVector<jitAsin>;
+        case Type::ACOS: return jitVector<jitAcos>;
+        case Type::ATAN: return jitVector<jitAtan>;
+        case Type::LOG: return jitElementary<Type::LOG>;
+        case Type::LN: return jitElementary<Type::LN>;
+        default: return nullptr;
+    }
+}
+
+// Условия vcmppd: сравнивается константа c с аргументом a
+enum Predicate : std::uint8_t {
+    kEqual = 0x00,         // c == a
+    kLess = 0x11,          // c < a
+    kGreaterEqual = 0x1D,  // c >= a
+    kGreater = 0x1E        // c > a
+};
+
+// Минимальный ассемблер x86-64: только инструкции, нужные генератору.
+// Все слоты адресуются как [rsp + disp32]
+class Assembler {
+public:
+    const std::vector<std::uint8_t>& code() const { return code_; }
+    std::size_t position() const { return code_.size(); }
+
+    void bytes(std::initializer_list<std::uint8_t> values) {
+        code_.insert(code_.end(), values.begin(), values.end());
+    }
+
+    void imm32(std::uint32_t value) {
+        for (int i = 0; i < 4; ++i) code_.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+    }
+
+    void imm64(std::uint64_t value) {
+        for (int i = 0; i < 8; ++i) code_.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+    }
+
+    // ModRM + SIB для [rsp + disp32]
+    void stackOperand(std::uint8_t reg, std::uint32_t disp) {
+        bytes({static_cast<std::uint8_t>(0x84 | reg << 3), 0x24});
+        imm32(disp);
+    }
+
+    // Условный переход rel32 с последующей привязкой к метке
+    void jump(std::uint8_t condition, std::vector<std::size_t>& fixups) {
+        bytes({0x0F, condition});
+        fixups.push_back(position());
+        imm32(0);
+    }
+
+    void bind(const std::vector<std::size_t>& fixups, std::size_t target) {
+        for (std::size_t at : fixups) {
+            std::uint32_t rel = static_cast<std::uint32_t>(target - (at + 4));
+            std::memcpy(code_.data() + at, &rel, sizeof(rel));
+        }
+    }
+
+    // Пролог: сохранение r12-r14, r12 = привязки, r13 = результат, кадр слотов
+    void prologue(std::uint32_t frame) {
+        bytes({0x41, 0x54, 0x41, 0x55, 0x41, 0x56});  // push r12; push r13; push r14
+        bytes({0x49, 0x89, 0xFC, 0x49, 0x89, 0xF5});  // mov r12, rdi; mov r13, rsi
+        bytes({0x48, 0x81, 0xEC});                    // sub rsp, frame
+        imm32(frame);
+    }
+
+    void epilogue(std::uint32_t frame) {
+        bytes({0x48, 0x81, 0xC4});  // add rsp, frame
+        imm32(frame);
+        bytes({0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0xC3});  // pop r14; pop r13; pop r12; ret
+    }
+
+    void movRaxImm(std::uint64_t value) {
+        bytes({0x48, 0xB8});
+        imm64(value);
+    }
+    void movRaxFromStack(std::uint32_t disp) {
+        bytes({0x48, 0x8B});
+        stackOperand(0, disp);
+    }
+    void movStackFromRax(std::uint32_t disp) {
+        bytes({0x48, 0x89});
+        stackOperand(0, disp);
+    }
+    void movRaxFromX(std::uint32_t disp) {
+        bytes({0x49, 0x8B, 0x84, 0x24});  // mov rax, [r12 + disp32]
+        imm32(disp);
+    }
+    void movResultFromRax(std::uint8_t disp) { bytes({0x49, 0x89, 0x45, disp}); }
+    void negateRax() { bytes({0x48, 0x0F, 0xBA, 0xF8, 0x3F}); }  // btc rax, 63
+    void callAddress(const void* address) {
+        movRaxImm(reinterpret_cast<std::uint64_t>(address));
+        bytes({0xFF, 0xD0});  // call rax
+    }
+    void leaStack(std::uint8_t reg, std::uint32_t disp) {
+        bytes({0x48, 0x8D});
+        stackOperand(reg, disp);
+    }
+
+    // SSE2, скаляр
+    void sse(std::uint8_t opcode, std::uint8_t reg, std::uint32_t disp) {
+        bytes({0xF2, 0x0F, opcode});
+        stackOperand(reg, disp);
+    }
+    // xmm1 = value
+    void loadXmm1(double value) {
+        if (value == 0 && !std::signbit(value)) {
+            bytes({0x66, 0x0F, 0x57, 0xC9});  // xorpd xmm1, xmm1
+        } else {
+            movRaxImm(std::bit_cast<std::uint64_t>(value));
+            bytes({0x66, 0x48, 0x0F, 0x6E, 0xC8});  // movq xmm1, rax
+        }
+    }
+
+    // AVX2, 4 точки; vvvv - второй источник в трехоперандной форме
+    void avx(std::uint8_t opcode, std::uint8_t reg, std::uint8_t vvvv, std::uint32_t disp) {
+        bytes({0xC5, static_cast<std::uint8_t>(0x85 | (~vvvv & 0xF) << 3), opcode});
+        stackOperand(reg, disp);
+    }
+    void vzeroupper() { bytes({0xC5, 0xF8, 0x77}); }
+
+private:
+    std::vector<std::uint8_t> code_;
+};
+
+// Коды операций SSE2 и AVX
+constexpr std::uint8_t kMovLoad = 0x10;
+constexpr std::uint8_t kMovStore = 0x11;
+constexpr std::uint8_t kSqrt = 0x51;
+constexpr std::uint8_t kXor = 0x57;
+constexpr std::uint8_t kAdd = 0x58;
+constexpr std::uint8_t kMul = 0x59;
+constexpr std::uint8_t kSub = 0x5C;
+constexpr std::uint8_t kDiv = 0x5E;
+constexpr std::uint8_t kCmp = 0xC2;
+// Коды условных переходов (второй байт 0F xx)
+constexpr std::uint8_t kJae = 0x83;
+constexpr std::uint8_t kJe = 0x84;
+constexpr std::uint8_t kJa = 0x87;
+
+std::uint8_t arithmeticOpcode(Type type) {
+    switch (type) {
+        case Type::PLUS: return kAdd;
+        case Type::MINUS: return kSub;
+        case Type::MULT: return kMul;
+        default: return kDiv;
+    }
+}
+
+// Генератор скалярной функции int f(const double* x, double* result).
+// Слоты по 8 байт: сначала временные значения, затем стек вычислений
+class ScalarGenerator {
+public:
+    ScalarGenerator(Assembler& as, const std::vector<double>& constants, std::size_t temps)
+        : as_(as), constants_(constants), temps_(temps) {}
+
+    void generate(const std::vector<Instruction>& code, std::size_t depth) {
+        const std::uint32_t frame = static_cast<std::uint32_t>((temps_ + depth) * 8 + 15) & ~15u;
+        as_.prologue(frame);
+        std::size_t size = 0;
+        for (const Instruction& ins : code) {
+            instruction(ins, size);
+            size = size - operandCount(ins.type) + 1;
+        }
+        as_.movRaxFromStack(slot(0));
+        as_.movResultFromRax(0);
+        as_.bytes({0x31, 0xC0});  // xor eax, eax
+        std::vector<std::size_t> done;
+        as_.bytes({0xE9});        // jmp done
+        done.push_back(as_.position());
+        as_.imm32(0);
+        as_.bind(errors_, as_.position());
+        as_.bytes({0xB8, 0x01, 0x00, 0x00, 0x00});  // mov eax, 1
+        as_.bind(done, as_.position());
+        as_.epilogue(frame);
+    }
+
+private:
+    std::uint32_t slot(std::size_t index) const { return static_cast<std::uint32_t>((temps_ + index) * 8); }
+    static std::uint32_t temp(std::uint32_t index) { return index * 8; }
+
+    // Переход к ошибке, если xmm0 == value / xmm0 < value / xmm0 <= value / xmm0 > value
+    void failIfEqual(double value) {
+        as_.loadXmm1(value);
+        as_.bytes({0x66, 0x0F, 0x2E, 0xC1, 0x7A, 0x06});  // ucomisd xmm0, xmm1; jp +6
+        as_.jump(kJe, errors_);
+    }
+    void failIfLess(double value) {
+        as_.loadXmm1(value);
+        as_.bytes({0x66, 0x0F, 0x2E, 0xC8});  // ucomisd xmm1, xmm0
+        as_.jump(kJa, errors_);
+    }
+    void failIfLessEqual(double value) {
+        as_.loadXmm1(value);
+        as_.bytes({0x66, 0x0F, 0x2E, 0xC8});  // ucomisd xmm1, xmm0
+        as_.jump(kJae, errors_);
+    }
+    void failIfGreater(double value) {
+        as_.loadXmm1(value);
+        as_.bytes({0x66, 0x0F, 0x2E, 0xC1});  // ucomisd xmm0, xmm1
+        as_.jump(kJa, errors_);
+    }
+
+    void instruction(const Instruction& ins, std::size_t size) {
+        const std::uint32_t a = slot(size - (operandCount(ins.type) == 2 ? 2 : 1));
+        const std::uint32_t b = slot(size - 1);
+        switch (ins.type) {
+            case Type::NUMBER:
+                as_.movRaxImm(std::bit_cast<std::uint64_t>(constants_[ins.operand]));
+                as_.movStackFromRax(slot(size));
+                break;
+            case Type::X:
+                as_.movRaxFromX(ins.operand * 8);
+                as_.movStackFromRax(slot(size));
+                break;
+            case Type::LOAD:
+                as_.movRaxFromStack(temp(ins.operand));
+                as_.movStackFromRax(slot(size));
+                break;
+            case Type::STORE:
+                as_.movRaxFromStack(a);
+                as_.movStackFromRax(temp(ins.operand));
+                break;
+            case Type::PLUS:
+            case Type::MINUS:
+            case Type::MULT:
+            case Type::DIV:
+                if (ins.type == Type::DIV) {
+                    as_.sse(kMovLoad, 0, b);
+                    failIfEqual(0);
+                }
+                as_.sse(kMovLoad, 0, a);
+                as_.sse(arithmeticOpcode(ins.type), 0, b);
+                as_.sse(kMovStore, 0, a);
+                break;
+            case Type::MOD:
+            case Type::POW:
+                if (ins.type == Type::MOD) {
+                    as_.sse(kMovLoad, 0, b);
+                    failIfEqual(0);
+                }
+                as_.sse(kMovLoad, 0, a);
+                as_.sse(kMovLoad, 1, b);
+                as_.callAddress(reinterpret_cast<const void*>(ins.type == Type::MOD ? jitFmod : jitPow));
+                as_.sse(kMovStore, 0, a);
+                break;
+            case Type::SQRT:
+                as_.sse(kMovLoad, 0, a);
+                failIfLess(0);
+                as_.bytes({0xF2, 0x0F, 0x51, 0xC0});  // sqrtsd xmm0, xmm0
+                as_.sse(kMovStore, 0, a);
+                break;
+            case Type::UNARY_MINUS:
+                as_.movRaxFromStack(a);
+                as_.negateRax();
+                as_.movStackFromRax(a);
+                break;
+            case Type::COT:
+                as_.sse(kMovLoad, 0, a);
+                as_.callAddress(reinterpret_cast<const void*>(jitTan));
+                failIfEqual(0);
+                as_.loadXmm1(1.0);
+                as_.bytes({0xF2, 0x0F, 0x5E, 0xC8});  // divsd xmm1, xmm0
+                as_.sse(kMovStore, 1, a);
+                break;
+            default:
+                as_.sse(kMovLoad, 0, a);
+                if (ins.type == Type::ASIN || ins.type == Type::ACOS) {
+                    failIfLess(-1);
+                    failIfGreater(1);
+                } else if (ins.type == Type::LOG || ins.type == Type::LN) {
+                    failIfLessEqual(0);
+                }
+                as_.callAddress(reinterpret_cast<const void*>(scalarFunction(ins.type)));
+                as_.sse(kMovStore, 0, a);
+                break;
+        }
+    }
+
+    Assembler& as_;
+    const std::vector<double>& constants_;
+    std::size_t temps_;
+    std::vector<std::size_t> errors_;  // Переходы к метке ошибки
+};
+
+// Генератор векторной функции unsigned f(const double* x, double* results)
+// на AVX2: 4 точки за инструкцию, возвращает маску точек вне области определения.
+// Слоты по 32 байта; значения переносятся только векторными загрузками и
+// записями, чтобы не срывать передачу данных из буфера записи
+class VectorGenerator {
+public:
+    VectorGenerator(Assembler& as, const std::vector<double>& constants, std::size_t temps,
+                    std::size_t variables)
+        : as_(as), constants_(constants), temps_(temps), variables_(variables) {}
+
+    void generate(const std::vector<Instruction>& code, std::size_t depth) {
+        const std::uint32_t frame = static_cast<std::uint32_t>((temps_ + depth) * 32);
+        as_.prologue(frame);
+        as_.bytes({0x45, 0x31, 0xF6});  // xor r14d, r14d
+        std::size_t size = 0;
+        for (const Instruction& ins : code) {
+            instruction(ins, size);
+            size = size - operandCount(ins.type) + 1;
+        }
+        as_.avx(kMovLoad, 0, 0, slot(0));
+        as_.bytes({0xC4, 0xC1, 0x7D, 0x11, 0x45, 0x00});  // vmovupd [r13], ymm0
+        as_.bytes({0x44, 0x89, 0xF0});                    // mov eax, r14d
+        as_.vzeroupper();
+        as_.epilogue(frame);
+    }
+
+private:
+    std::uint32_t slot(std::size_t index) const { return static_cast<std::uint32_t>((temps_ + index) * 32); }
+    static std::uint32_t temp(std::uint32_t index) { return index * 32; }
+
+    // ymm<reg> = value во всех 4 элементах
+    void broadcast(std::uint8_t reg, double value) {
+        as_.movRaxImm(std::bit_cast<std::uint64_t>(value));
+        as_.bytes({0xC4, 0xE1, 0xF9, 0x6E, static_cast<std::uint8_t>(0xC0 | reg << 3)});  // vmovq xmm, rax
+        as_.bytes({0xC4, 0xE2, 0x7D, 0x19, static_cast<std::uint8_t>(0xC0 | reg << 3 | reg)});  // vbroadcastsd
+    }
+    void copy(std::uint32_t from, std::uint32_t to) {
+        as_.avx(kMovLoad, 0, 0, from);
+        as_.avx(kMovStore, 0, 0, to);
+    }
+    // Отметка точек, где выполняется value <predicate> a
+    void mark(double value, Predicate predicate, std::uint32_t a) {
+        broadcast(1, value);
+        as_.avx(kCmp, 2, 1, a);  // vcmppd ymm2, ymm1, [a], predicate
+        as_.bytes({predicate});
+        as_.bytes({0xC5, 0xFD, 0x50, 0xC2});  // vmovmskpd eax, ymm2
+        as_.bytes({0x41, 0x09, 0xC6});        // or r14d, eax
+    }
+    // ymm0 = столбец переменной slot из 4 строк привязок
+    void gather(std::uint32_t slot) {
+        auto lane = [&](std::uint8_t opcode_byte, std::uint8_t vex, std::uint8_t reg, std::size_t index) {
+            as_.bytes({0xC4, 0xC1, vex, opcode_byte, static_cast<std::uint8_t>(0x84 | reg << 3), 0x24});
+            as_.imm32(static_cast<std::uint32_t>((index * variables_ + slot) * 8));
+        };
+        lane(0x10, 0x7B, 0, 0);  // vmovsd xmm0, [r12 + d0]
+        lane(0x16, 0x79, 0, 1);  // vmovhpd xmm0, xmm0, [r12 + d1]
+        lane(0x10, 0x7B, 1, 2);  // vmovsd xmm1, [r12 + d2]
+        lane(0x16, 0x71, 1, 3);  // vmovhpd xmm1, xmm1, [r12 + d3]
+        as_.bytes({0xC4, 0xE3, 0x7D, 0x18, 0xC1, 0x01});  // vinsertf128 ymm0, ymm0, xmm1, 1
+    }
+    void call(const void* address, std::uint32_t a) {
+        as_.leaStack(7, a);  // lea rdi, [a]
+        as_.vzeroupper();
+        as_.callAddress(address);
+    }
+
+    void instruction(const Instruction& ins, std::size_t size) {
+        const std::uint32_t a = slot(size - (operandCount(ins.type) == 2 ? 2 : 1));
+        const std::uint32_t b = slot(size - 1);
+        switch (ins.type) {
+            case Type::NUMBER:
+                broadcast(0, constants_[ins.operand]);
+                as_.avx(kMovStore, 0, 0, slot(size));
+                break;
+            case Type::X:
+                if (variables_ == 1) {
+                    as_.bytes({0xC4, 0xC1, 0x7D, 0x10, 0x04, 0x24});  // vmovupd ymm0, [r12]
+                } else {
+                    gather(ins.operand);
+                }
+                as_.avx(kMovStore, 0, 0, slot(size));
+                break;
+            case Type::LOAD:
+                copy(temp(ins.operand), slot(size));
+                break;
+            case Type::STORE:
+                copy(a, temp(ins.operand));
+                break;
+            case Type::PLUS:
+            case Type::MINUS:
+            case Type::MULT:
+            case Type::DIV:
+                if (ins.type == Type::DIV) mark(0, kEqual, b);
+                as_.avx(kMovLoad, 0, 0, a);
+                as_.avx(arithmeticOpcode(ins.type), 0, 0, b);
+                as_.avx(kMovStore, 0, 0, a);
+                break;
+            case Type::MOD:
+            case Type::POW:
+                if (ins.type == Type::MOD) mark(0, kEqual, b);
+                as_.leaStack(6, b);  // lea rsi, [b]
+                call(reinterpret_cast<const void*>(ins.type == Type::MOD ? jitVector2<jitFmod>
+                                                                         : jitElementaryPow),
+                     a);
+                break;
+            case Type::SQRT:
+                mark(0, kGreater, a);
+                as_.avx(kSqrt, 0, 0, a);
+                as_.avx(kMovStore, 0, 0, a);
+                break;
+            case Type::UNARY_MINUS:
+                broadcast(1, -0.0);
+                as_.avx(kXor, 0, 1, a);  // vxorpd ymm0, ymm1, [a]
+                as_.avx(kMovStore, 0, 0, a);
+                break;
+            case Type::COT:
+                call(reinterpret_cast<const void*>(vectorFunction(Type::TAN)), a);
+                mark(0, kEqual, a);
+                broadcast(1, 1.0);
+                as_.avx(kDiv, 1, 1, a);  // vdivpd ymm1, ymm1, [a]
+                as_.avx(kMovStore, 1, 0, a);
+                break;
+            default:
+                if (ins.type == Type::ASIN || ins.type == Type::ACOS) {
+                    mark(-1, kGreater, a);
+                    mark(1, kLess, a);
+                } else if (ins.type == Type::LOG || ins.type == Type::LN) {
+                    mark(0, kGreaterEqual, a);
+                }
+                call(reinterpret_cast<const void*>(vectorFunction(ins.type)), a);
+                break;
+        }
+    }
+
+    Assembler& as_;
+    const std::vector<double>& constants_;
+    std::size_t temps_;
+    std::size_t variables_;
+};
+
+// Проверка программы: глубина стека или 0, если программа некорректна
+std::size_t programDepth(const std::vector<Instruction>& code, const std::vector<double>& constants,
+                         std::size_t temps, std::size_t variables) {
+    std::size_t depth = 0, max_depth = 0;
+    for (const Instruction& ins : code) {
+        int operands = operandCount(ins.type);
+        if (operands < 0 || depth < static_cast<std::size_t>(operands)) return 0;
+        if (ins.type == Type::NUMBER && ins.operand >= constants.size()) return 0;
+        if ((ins.type == Type::LOAD || ins.type == Type::STORE) && ins.operand >= temps) return 0;
+        if (ins.type == Type::X && ins.operand >= variables) return 0;
+        depth = depth - operands + 1;
+        max_depth = std::max(max_depth, depth);
+    }
+    return depth == 1 ? max_depth : 0;
+}
+
+}  // namespace
+
+bool JitProgram::available() { return true; }
+
+std::shared_ptr<const JitProgram> JitProgram::compile(const std::vector<Instruction>& code,
+                                                      const std::vector<double>& constants,
+                                                      std::size_t temps, std::size_t variables) {
+    const std::size_t depth = programDepth(code, constants, temps, variables);
+    // Смещения слотов и привязок кодируются 32 битами
+    if (depth == 0 || (temps + depth + 1) * 32 > (1u << 30) || variables * 32 > (1u << 30)) return nullptr;
+
+    Assembler as;
+    ScalarGenerator(as, constants, temps).generate(code, depth);
+    std::size_t vector_offset = 0;
+    if (__builtin_cpu_supports("avx2")) {
+        vector_offset = as.position();
+        VectorGenerator(as, constants, temps, variables).generate(code, depth);
+    }
+
+    // Код пишется в память RW, затем она переводится в RX
+    const std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const std::size_t size = (as.position() + page - 1) / page * page;
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return nullptr;
+    std::memcpy(memory, as.code().data(), as.position());
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, size);
+        return nullptr;
+    }
+
+    std::shared_ptr<JitProgram> program(new JitProgram());
+    program->memory_ = memory;
+    program->size_ = size;
+    auto* base = static_cast<std::uint8_t*>(memory);
+    program->scalar_ = reinterpret_cast<ScalarFunction>(base);
+    if (vector_offset != 0) program->vector_ = reinterpret_cast<VectorFunction>(base + vector_offset);
+    return program;
+}
+
+JitProgram::~JitProgram() {
+    if (memory_ != nullptr) munmap(memory_, size_);
+}
+
+#else  // S21_JIT_X86_64
+
+bool JitProgram::available() { return false; }
+
+std::shared_ptr<const JitProgram> JitProgram::compile(const std::vector<Instruction>&,
+                                                      const std::vector<double>&, std::size_t,
+                                                      std::size_t) {
+    return nullptr;
+}
+
+JitProgram::~JitProgram() = default;
+
+#endif  // S21_JIT_X86_64
+
+bool JitProgram::run(const double* bindings, double& result) const {
+    return scalar_(bindings, &result) == 0;
+}
+
+void JitProgram::runBlock(const double* rows, std::size_t stride, double* results,
+                          std::uint8_t* invalid, std::size_t lanes) const {
+    std::size_t i = 0;
+    for (; i + 4 <= lanes; i += 4) {
+        unsigned mask = vector_(rows + i * stride, results + i);
+        for (std::size_t lane = 0; lane < 4; ++lane) invalid[i + lane] = (mask >> lane) & 1;
+    }
+    if (i == lanes) return;
+    // Хвост тоже считается векторным кодом: результат точки не зависит от ее
+    // места, поэтому пересчитываются последние 4 точки блока, а блок меньше
+    // 4 точек дополняется копиями последней строки
+    double tail[4];
+    std::size_t first = 0;  // Точка блока, попавшая в tail[0]
+    unsigned mask;
+    if (lanes >= 4) {
+        first = lanes - 4;
+        mask = vector_(rows + first * stride, tail);
+    } else {
+        std::vector<double> padded(4 * stride);
+        for (std::size_t lane = 0; lane < 4; ++lane) {
+            std::copy_n(rows + std::min(lane, lanes - 1) * stride, stride, padded.data() + lane * stride);
+        }
+        mask = vector_(padded.data(), tail);
+    }
+    for (; i < lanes; ++i) {
+        results[i] = tail[i - first];
+        invalid[i] = (mask >> (i - first)) & 1;
+    }
+}
+
+}  // namespace s21
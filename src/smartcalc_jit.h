@@ -0,0 +1,60 @@
+#ifndef SMARTCALC_JIT_H
+#define SMARTCALC_JIT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "smartcalc_model.h"
+
+namespace s21 {
+
+// Машинный код скомпилированного выражения для x86-64 (System V ABI).
+// Скалярная версия использует SSE2 и вызывает libm, как скалярный интерпретатор.
+// Пакетная обрабатывает по 4 точки на AVX2 и считает sin, cos, ln, log и pow
+// ядрами simd, как интерпретатор блоков. Поэтому результаты обеих версий
+// побитово совпадают с интерпретатором (расхождение 0 ulp)
+class JitProgram {
+public:
+    // Доступна ли генерация кода на этой платформе
+    static bool available();
+
+    // Генерация кода для программы; nullptr, если JIT недоступен
+    // или программа некорректна (тогда работает интерпретатор)
+    static std::shared_ptr<const JitProgram> compile(const std::vector<Instruction>& code,
+                                                     const std::vector<double>& constants,
+                                                     std::size_t temps, std::size_t variables = 1);
+
+    ~JitProgram();
+    JitProgram(const JitProgram&) = delete;
+    JitProgram& operator=(const JitProgram&) = delete;
+
+    // Вычисление в точке по массиву привязок; false при ошибке области определения
+    bool run(const double* bindings, double& result) const;
+
+    // Вычисление блока точек векторной версией (только при vectorized()); привязки
+    // точки i начинаются с rows[i * stride], stride равен числу переменных.
+    // invalid[i] = 1 для точек вне области определения. Конечность результатов
+    // не проверяется
+    void runBlock(const double* rows, std::size_t stride, double* results, std::uint8_t* invalid,
+                  std::size_t lanes) const;
+
+    // Есть ли векторная (AVX2) версия
+    bool vectorized() const { return vector_ != nullptr; }
+
+private:
+    using ScalarFunction = int (*)(const double* bindings, double* result);
+    using VectorFunction = unsigned (*)(const double* rows, double* results);
+
+    JitProgram() = default;
+
+    void* memory_ = nullptr;  // Исполняемая память
+    std::size_t size_ = 0;
+    ScalarFunction scalar_ = nullptr;
+    VectorFunction vector_ = nullptr;
+};
+
+}  // namespace s21
+
+#endif  // SMARTCALC_JIT_H
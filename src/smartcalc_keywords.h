@@ -0,0 +1,86 @@
+#ifndef SMARTCALC_KEYWORDS_H
+#define SMARTCALC_KEYWORDS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "smartcalc_model.h"
+
+namespace s21 {
+
+// Ключевое слово выражения: функция или словесный оператор
+struct Keyword {
+    std::string_view name;  // Строчные латинские буквы
+    Type type;
+    Priority priority;
+};
+
+// Таблица ключевых слов; новая функция добавляется одной строкой
+inline constexpr Keyword kKeywords[] = {
+    {"mod", Type::MOD, Priority::MIDDLE},   {"sin", Type::SIN, Priority::UNARY},
+    {"cos", Type::COS, Priority::UNARY},    {"tan", Type::TAN, Priority::UNARY},
+    {"cot", Type::COT, Priority::UNARY},    {"asin", Type::ASIN, Priority::UNARY},
+    {"acos", Type::ACOS, Priority::UNARY},  {"atan", Type::ATAN, Priority::UNARY},
+    {"sqrt", Type::SQRT, Priority::UNARY},  {"log", Type::LOG, Priority::UNARY},
+    {"ln", Type::LN, Priority::UNARY},
+};
+
+// Число узлов дерева ключевых слов: не больше суммарной длины слов плюс корень
+constexpr std::size_t keywordTrieCapacity() {
+    std::size_t size = 1;
+    for (const Keyword& keyword : kKeywords) size += keyword.name.size();
+    return size;
+}
+
+static_assert(keywordTrieCapacity() <= 256, "Keyword trie indices are 8-bit");
+
+// Префиксное дерево ключевых слов, построенное при компиляции. Распознавание
+// идет за один проход по символам входа, независимо от числа слов в таблице
+class KeywordTrie {
+public:
+    constexpr KeywordTrie() {
+        for (std::size_t k = 0; k < std::size(kKeywords); ++k) {
+            std::size_t node = 0;
+            for (char ch : kKeywords[k].name) {
+                std::uint8_t& next = nodes_[node].next[ch - 'a'];
+                if (next == 0) next = static_cast<std::uint8_t>(size_++);
+                node = next;
+            }
+            nodes_[node].keyword = static_cast<std::int8_t>(k);
+        }
+    }
+
+    // Самое длинное ключевое слово в начале text; nullptr, если его нет
+    constexpr const Keyword* match(std::string_view text) const {
+        const Keyword* found = nullptr;
+        std::size_t node = 0;
+        for (char ch : text) {
+            if (ch < 'a' || ch > 'z') break;
+            node = nodes_[node].next[ch - 'a'];
+            if (node == 0) break;
+            if (nodes_[node].keyword >= 0) found = &kKeywords[nodes_[node].keyword];
+        }
+        return found;
+    }
+
+private:
+    struct Node {
+        std::array<std::uint8_t, 26> next{};  // Переход по букве; 0 - нет перехода
+        std::int8_t keyword = -1;             // Индекс слова, оканчивающегося здесь
+    };
+
+    std::array<Node, keywordTrieCapacity()> nodes_{};
+    std::size_t size_ = 1;
+};
+
+inline constexpr KeywordTrie kKeywordTrie{};
+
+static_assert(kKeywordTrie.match("sqrt(x)")->type == Type::SQRT);
+static_assert(kKeywordTrie.match("ln(x)")->type == Type::LN);
+static_assert(kKeywordTrie.match("x") == nullptr);
+
+}  // namespace s21
+
+#endif  // SMARTCALC_KEYWORDS_H
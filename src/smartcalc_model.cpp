@@ -1,341 +1,458 @@
 #include "smartcalc_model.h"
+#include "smartcalc_jit.h"
+#include "smartcalc_keywords.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <new>
 #include <stdexcept>
-#include <stack>
 #include <cmath>
 
 namespace s21 {
 
-bool SmartCalcModel::isOperator(char ch) {
+bool SmartCalcModel::isOperator(char ch) const {
     return ch == '+' || ch == '-' || ch == '*' || ch == '/' || ch == '^' || ch == 'm'; // 'm' для "mod"
 }
 
 // Основная функция парсинга выражения
-double SmartCalcModel::parse(const std::string& expression, double x_value) {
+double SmartCalcModel::parse(const std::string& expression, double x_value) const {
+    return compile(expression).evaluate(x_value);
+}
+
+// Вычисление скомпилированного выражения для массива значений x
+void SmartCalcModel::evaluate(const CompiledExpression& compiled, std::span<const double> x_values,
+                              std::span<double> results, std::span<std::uint8_t> valid) const {
+    compiled.evaluate(x_values, results, valid);
+}
+
+// Параллельное вычисление скомпилированного выражения для массива значений x
+void SmartCalcModel::evaluateParallel(const CompiledExpression& compiled,
+                                      std::span<const double> x_values, std::span<double> results,
+                                      std::span<std::uint8_t> valid, std::size_t chunk_size) const {
+    compiled.evaluateParallel(x_values, results, valid, chunk_size);
+}
+
+// Разбор выражения и построение RPN без вычисления
+CompiledExpression SmartCalcModel::compile(std::string_view expression,
+                                           const CompileOptions& options) const {
     if (expression.empty()) {
         throw std::invalid_argument("Empty expression.");
     }
 
-    std::shared_ptr<Node> calc = nullptr;
-    double result = 0;
-    std::string tmp_str;
+    if (!checkBrackets(expression)) {
+        throw std::invalid_argument("Mismatched parentheses in expression.");
+    }
+
+    // Лексер и сортировочная станция работают за один проход: токены не
+    // накапливаются, в памяти живут только байт-код и стек операторов.
+    // Стек операторов размещается в арене со встроенным буфером на стеке
+    // Имена переменных по слотам; по умолчанию единственная переменная x
+    static const std::vector<std::string> kDefaultVariables{"x"};
+    const std::vector<std::string>& variables =
+        options.variables.empty() ? kDefaultVariables : options.variables;
+    for (std::size_t k = 0; k < variables.size(); ++k) {
+        const std::string& name = variables[k];
+        bool valid = !name.empty() && (isalpha(name[0]) || name[0] == '_') &&
+                     std::all_of(name.begin(), name.end(), [](char ch) { return isalnum(ch) || ch == '_'; }) &&
+                     !(kKeywordTrie.match(name) && kKeywordTrie.match(name)->name.size() == name.size()) &&
+                     matchVariable(name, variables, true) == k;
+        if (!valid) throw std::invalid_argument("Invalid variable name.");
+    }
+
+    std::array<std::byte, kArenaInlineSize> arena_buffer;
+    std::pmr::monotonic_buffer_resource arena(arena_buffer.data(), arena_buffer.size());
+    TokenList operators(&arena);
+    operators.reserve(kInlineOperators);
+    CompiledExpression compiled;
+    compiled.variables_ = variables.size();
+    compiled.precision_ = options.precision;
+    bool has_tokens = false;  // Встретился ли хотя бы один токен
+    // Ожидается ли операнд: в начале, после скобки и после операторов.
+    // Тогда плюс и минус унарные
+    bool operand_expected = true;
+    auto push = [&](double value, Priority priority, Type type, std::size_t position) {
+        pushBack(operators, compiled, value, priority, type, position);
+        operand_expected = type != Type::NUMBER && type != Type::X && type != Type::ROUNDBRACKET_R;
+    };
 
-    for (size_t i = 0; i < expression.length(); ++i) {
+    for (std::size_t i = 0; i < expression.length(); ++i) {
         if (expression[i] == ' ') continue;
+        has_tokens = true;
+        // Остаток строки для распознавания ключевых слов
+        const std::string_view rest = expression.substr(i);
         if (isdigit(expression[i]) || expression[i] == '.') {
-            tmp_str += expression[i];
-        } else {
-            if (!tmp_str.empty()) {
-                pushBack(calc, std::stod(tmp_str), Priority::SHORT, Type::NUMBER);
-                tmp_str.clear();
+            // Число - цифры и точки; пробелы внутри числа, как и везде, игнорируются
+            std::size_t end = i;
+            for (std::size_t j = i; j < expression.length(); ++j) {
+                if (expression[j] == ' ') continue;
+                if (!isdigit(expression[j]) && expression[j] != '.') break;
+                end = j + 1;
             }
-            if (expression[i] == 'x') {
-                pushBack(calc, x_value, Priority::SHORT, Type::X);
-            } else if (expression[i] == '+') {
-                if (i == 0 || expression[i - 1] == '(' || isOperator(expression[i - 1])) {
-                    continue; // Унарный плюс игнорируется
-                } else {
-                    pushBack(calc, 0, Priority::SHORT, Type::PLUS);
-                }
-            } else if (expression[i] == '-') {
-                if (i == 0 || expression[i - 1] == '(' || isOperator(expression[i - 1])) {
-                    pushBack(calc, 0, Priority::UNARY, Type::UNARY_MINUS);
-                } else {
-                    pushBack(calc, 0, Priority::SHORT, Type::MINUS);
+            push(parseNumber(expression.substr(i, end - i)), Priority::SHORT, Type::NUMBER, i);
+            i = end - 1;
+        } else if (isalpha(expression[i]) || expression[i] == '_') {
+            // Идентификатор: переменная целиком, затем ключевое слово в начале
+            // (слитная запись "sinx"), затем самое длинное имя переменной в начале
+            std::size_t end = i;
+            while (end < expression.length() && (isalnum(expression[end]) || expression[end] == '_')) ++end;
+            const std::string_view identifier = expression.substr(i, end - i);
+            std::size_t slot = matchVariable(identifier, variables, true);
+            if (slot == variables.size()) {
+                if (const Keyword* keyword = kKeywordTrie.match(rest)) {
+                    push(0, keyword->priority, keyword->type, i);
+                    i += keyword->name.size() - 1;
+                    continue;
                 }
-            } else if (expression[i] == '*') {
-                pushBack(calc, 0, Priority::MIDDLE, Type::MULT);
-            } else if (expression[i] == '/') {
-                pushBack(calc, 0, Priority::MIDDLE, Type::DIV);
-            } else if (expression[i] == '^') {
-                pushBack(calc, 0, Priority::HIGH, Type::POW);
-            } else if (expression.substr(i, 3) == "mod") {
-                pushBack(calc, 0, Priority::MIDDLE, Type::MOD);
-                i += 2;
-            } else if (expression.substr(i, 3) == "sin") {
-                pushBack(calc, 0, Priority::UNARY, Type::SIN);
-                i += 2;
-            } else if (expression.substr(i, 3) == "cos") {
-                pushBack(calc, 0, Priority::UNARY, Type::COS);
-                i += 2;
-            } else if (expression.substr(i, 3) == "tan") {
-                pushBack(calc, 0, Priority::UNARY, Type::TAN);
-                i += 2;
-            } else if (expression.substr(i, 3) == "cot") {
-                pushBack(calc, 0, Priority::UNARY, Type::COT);
-                i += 2;
-            } else if (expression.substr(i, 4) == "asin") {
-                pushBack(calc, 0, Priority::UNARY, Type::ASIN);
-                i += 3;
-            } else if (expression.substr(i, 4) == "acos") {
-                pushBack(calc, 0, Priority::UNARY, Type::ACOS);
-                i += 3;
-            } else if (expression.substr(i, 4) == "atan") {
-                pushBack(calc, 0, Priority::UNARY, Type::ATAN);
-                i += 3;
-            } else if (expression.substr(i, 4) == "sqrt") {
-                pushBack(calc, 0, Priority::UNARY, Type::SQRT);
-                i += 3;
-            } else if (expression.substr(i, 3) == "log") {
-                pushBack(calc, 0, Priority::UNARY, Type::LOG);
-                i += 2;
-            } else if (expression.substr(i, 2) == "ln") {
-                pushBack(calc, 0, Priority::UNARY, Type::LN);
-                i += 1;
-            } else if (expression[i] == '(') {
-                pushBack(calc, 0, Priority::ROUNDBRACKET, Type::ROUNDBRACKET_L);
-            } else if (expression[i] == ')') {
-                pushBack(calc, 0, Priority::ROUNDBRACKET, Type::ROUNDBRACKET_R);
+                slot = matchVariable(identifier, variables, false);
+                if (slot == variables.size()) throw std::invalid_argument("Invalid character in expression.");
+            }
+            push(static_cast<double>(slot), Priority::SHORT, Type::X, i);
+            i += variables[slot].size() - 1;
+        } else if (expression[i] == '+') {
+            // Унарный плюс игнорируется
+            if (!operand_expected) push(0, Priority::SHORT, Type::PLUS, i);
+        } else if (expression[i] == '-') {
+            if (operand_expected) {
+                push(0, Priority::UNARY, Type::UNARY_MINUS, i);
             } else {
-                throw std::invalid_argument("Invalid character in expression.");
+                push(0, Priority::SHORT, Type::MINUS, i);
             }
+        } else if (expression[i] == '*') {
+            push(0, Priority::MIDDLE, Type::MULT, i);
+        } else if (expression[i] == '/') {
+            push(0, Priority::MIDDLE, Type::DIV, i);
+        } else if (expression[i] == '^') {
+            push(0, Priority::HIGH, Type::POW, i);
+        } else if (expression[i] == '(') {
+            push(0, Priority::ROUNDBRACKET, Type::ROUNDBRACKET_L, i);
+        } else if (expression[i] == ')') {
+            push(0, Priority::ROUNDBRACKET, Type::ROUNDBRACKET_R, i);
+        } else {
+            throw std::invalid_argument("Invalid character in expression.");
         }
     }
 
-    if (!tmp_str.empty()) {
-        pushBack(calc, std::stod(tmp_str), Priority::SHORT, Type::NUMBER);
-    }    
-    
-    if (!checkBrackets(expression)) {
-        throw std::invalid_argument("Mismatched parentheses in expression.");
+    if (has_tokens) {
+        flushOperators(operators, compiled);
+        if (compiled.empty()) throw std::invalid_argument("Invalid RPN transformation.");
+        foldConstants(compiled);
+        optimizeDag(compiled);
+        compiled.depth_ = compiled.stackDepth();
+        // Машинный код генерируется только для double
+        if (options.jit && options.precision == Precision::DOUBLE) {
+            compiled.jit_ = JitProgram::compile(compiled.code_, compiled.constants_, compiled.temps_,
+                                                compiled.variables_);
+        }
     }
+    return compiled;
+}
 
-    if (calc) {
-        calc = RPN(calc);
-        if (!calc) throw std::invalid_argument("Invalid RPN transformation.");
-        result = calcExpression(calc);
-    }
-    
-    if (std::isnan(result) || std::isinf(result)) {
-        throw std::invalid_argument("Invalid expression result.");
-    }
-    return result;
+// Вычисление скомпилированного выражения для заданного x
+double CompiledExpression::evaluate(double x_value) const {
+    return evaluate(std::span<const double>(&x_value, 1));
 }
 
-// Преобразование в RPN
-std::shared_ptr<Node> SmartCalcModel::RPN(std::shared_ptr<Node> end) {
-    std::stack<std::shared_ptr<Node>> opStack;
-    std::shared_ptr<Node> output = nullptr;
-    
-    while (end) {
-        switch (end->type) {
-            case Type::NUMBER:
-            case Type::X:
-                pushBack(output, end->value, Priority::SHORT, end->type);
-                break;
-                
-            case Type::ROUNDBRACKET_L:
-                opStack.push(std::make_shared<Node>(*end));
-                break;
-                
-            case Type::ROUNDBRACKET_R:
-                while (!opStack.empty() && opStack.top()->type != Type::ROUNDBRACKET_L) {
-                    pushBack(output, 0, opStack.top()->priority, opStack.top()->type);
-                    opStack.pop();
-                }
-                if (!opStack.empty()) opStack.pop();
-                else throw std::invalid_argument("Mismatched parentheses");
-                break;
-                
-            case Type::UNARY_MINUS:
-            case Type::SIN:
-            case Type::COS:
-            case Type::TAN:
-            case Type::ASIN:
-            case Type::ACOS:
-            case Type::ATAN:
-            case Type::SQRT:
-            case Type::LOG:
-            case Type::LN:
-                opStack.push(std::make_shared<Node>(*end));
-                break;
-                
-            default:
-                while (!opStack.empty() && 
-                       opStack.top()->type != Type::ROUNDBRACKET_L &&
-                       (opStack.top()->priority >= end->priority &&
-                        end->type != Type::POW)) {
-                    pushBack(output, 0, opStack.top()->priority, opStack.top()->type);
-                    opStack.pop();
-                }
-                opStack.push(std::make_shared<Node>(*end));
-                break;
-        }
-        end = end->next;
+double CompiledExpression::evaluate(std::span<const double> bindings) const {
+    EvalResult result = tryEvaluate(bindings);
+    if (!result) throw std::invalid_argument(errorMessage(result.error().kind));
+    return result.value();
+}
+
+EvalResult CompiledExpression::tryEvaluate(double x_value) const noexcept {
+    return tryEvaluate(std::span<const double>(&x_value, 1));
+}
+
+EvalResult CompiledExpression::tryEvaluate(std::span<const double> bindings) const noexcept {
+    if (code_.empty()) return 0.0;
+    if (bindings.size() < variables_) return EvalError{ErrorKind::BINDING_SIZE, 0};
+    // Машинный код не различает виды ошибок: при ошибке области определения
+    // точку пересчитывает интерпретатор
+    double result = 0;
+    if (jit_ && jit_->run(bindings.data(), result)) {
+        if (std::isfinite(result)) return result;
+        return EvalError{ErrorKind::NOT_FINITE, positions_.back()};
     }
-    
-    while (!opStack.empty()) {
-        if (opStack.top()->type == Type::ROUNDBRACKET_L) {
-            throw std::invalid_argument("Mismatched parentheses");
+    const std::size_t size = temps_ + depth_;
+    try {
+        if (precision_ == Precision::FLOAT) {
+            std::array<float, kInlineStackSize> inline_stack;
+            return calcExpression(bindings.data(),
+                                  size <= inline_stack.size() ? inline_stack.data() : scratch<float>(size));
         }
-        pushBack(output, 0, opStack.top()->priority, opStack.top()->type);
-        opStack.pop();
+        std::array<double, kInlineStackSize> inline_stack;
+        return calcExpression(bindings.data(),
+                              size <= inline_stack.size() ? inline_stack.data() : scratch<double>(size));
+    } catch (const std::bad_alloc&) {
+        // Буфер стека потока не удалось увеличить
+        return EvalError{ErrorKind::OUT_OF_MEMORY, 0};
     }
-    
-    return output;
 }
 
-double SmartCalcModel::calcExpression(std::shared_ptr<Node> rpn) {
-    std::stack<double> stack;
-    while (rpn) {
-        switch (rpn->type) {
-            case Type::NUMBER:
-            case Type::X:
-                stack.push(rpn->value);
-                break;
+// Буфер растет до наибольшей потребовавшейся глубины и дальше
+// не перераспределяется, поэтому повторные вычисления не выделяют память.
+// Для double, float и Dual буферы отдельные
+template <class T>
+T* CompiledExpression::scratch(std::size_t size) {
+    thread_local std::vector<T> buffer;
+    if (buffer.size() < size) buffer.resize(size);
+    return buffer.data();
+}
 
-            case Type::PLUS: {
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double b = stack.top(); stack.pop();
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double a = stack.top(); stack.pop();
-                stack.push(a + b);
-                break;
-            }
+// Шаг сортировочной станции для очередного токена: операнды и вытесненные
+// операторы сразу выписываются в байт-код, остальные ждут в стеке операторов
+void SmartCalcModel::RPN(TokenList& operators, CompiledExpression& compiled, const Token& token) {
+    switch (token.type) {
+        case Type::NUMBER:
+        case Type::X:
+            emit(compiled, token);
+            break;
 
-            case Type::MINUS: {
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double b = stack.top(); stack.pop();
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double a = stack.top(); stack.pop();
-                stack.push(a - b);
-                break;
-            }
+        case Type::ROUNDBRACKET_L:
+            operators.push_back(token);
+            break;
 
-            case Type::MULT: {
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double b = stack.top(); stack.pop();
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double a = stack.top(); stack.pop();
-                stack.push(a * b);
-                break;
+        case Type::ROUNDBRACKET_R:
+            while (!operators.empty() && operators.back().type != Type::ROUNDBRACKET_L) {
+                emit(compiled, operators.back());
+                operators.pop_back();
             }
+            if (!operators.empty()) operators.pop_back();
+            else throw std::invalid_argument("Mismatched parentheses");
+            break;
 
-            case Type::DIV: {
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double b = stack.top(); stack.pop();
-                if (b == 0) throw std::invalid_argument("Division by zero.");
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double a = stack.top(); stack.pop();
-                stack.push(a / b);
-                break;
-            }
+        case Type::UNARY_MINUS:
+        case Type::SIN:
+        case Type::COS:
+        case Type::TAN:
+        case Type::ASIN:
+        case Type::ACOS:
+        case Type::ATAN:
+        case Type::SQRT:
+        case Type::LOG:
+        case Type::LN:
+            operators.push_back(token);
+            break;
 
-            case Type::POW: {
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double b = stack.top(); stack.pop();
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double a = stack.top(); stack.pop();
-                stack.push(std::pow(a, b));
-                break;
+        default:
+            while (!operators.empty() &&
+                   operators.back().type != Type::ROUNDBRACKET_L &&
+                   (operators.back().priority >= token.priority &&
+                    token.type != Type::POW)) {
+                emit(compiled, operators.back());
+                operators.pop_back();
             }
+            operators.push_back(token);
+            break;
+    }
+}
 
-            case Type::MOD: {
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double b = stack.top(); stack.pop();
-                if (b == 0) throw std::invalid_argument("Modulo by zero.");
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double a = stack.top(); stack.pop();
-                stack.push(std::fmod(a, b));
-                break;
-            }
+// Выписывание оставшихся операторов в конце выражения
+void SmartCalcModel::flushOperators(TokenList& operators, CompiledExpression& compiled) {
+    while (!operators.empty()) {
+        if (operators.back().type == Type::ROUNDBRACKET_L) {
+            throw std::invalid_argument("Mismatched parentheses");
+        }
+        emit(compiled, operators.back());
+        operators.pop_back();
+    }
+}
 
-            case Type::SIN: {
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double a = stack.top(); stack.pop();
-                stack.push(std::sin(a));
+// Стек вычисления начинается после временных значений общих подвыражений
+template <class T>
+EvalResult CompiledExpression::calcExpression(const double* bindings, T* stack) const noexcept {
+    // Структура программы проверена при компиляции: первые temps_ ячеек
+    // занимают временные значения, за ними растет стек
+    T* top = stack + temps_;  // Первая свободная ячейка
+    ErrorKind error = ErrorKind::NONE;
+    for (std::size_t i = 0; i < code_.size(); ++i) {
+        const Instruction& ins = code_[i];
+        switch (operandCount(ins.type)) {
+            case 0:
+                if (ins.type == Type::X) *top++ = static_cast<T>(bindings[ins.operand]);
+                else if (ins.type == Type::LOAD) *top++ = stack[ins.operand];
+                else *top++ = static_cast<T>(constants_[ins.operand]);
                 break;
-            }
 
-            case Type::COS: {
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double a = stack.top(); stack.pop();
-                stack.push(std::cos(a));
+            case 1:
+                if (ins.type == Type::STORE) stack[ins.operand] = top[-1];
+                else top[-1] = trigonometry(top[-1], ins.type, error);
                 break;
-            }
 
-            case Type::TAN: {
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double a = stack.top(); stack.pop();
-                stack.push(std::tan(a));
+            case 2:
+                --top;
+                top[-1] = arithmetic(top[-1], *top, ins.type, error);
                 break;
-            }
 
-            case Type::COT: {
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double a = stack.top(); stack.pop();
-                double tan_a = std::tan(a);
-                if (tan_a == 0) throw std::invalid_argument("Cotangent undefined at this point.");
-                stack.push(1.0 / tan_a);
-                break;
-            }
+            default:
+                error = ErrorKind::UNKNOWN_OPERATOR;
+        }
+        if (error != ErrorKind::NONE) return EvalError{error, positions_[i]};
+    }
 
-            case Type::ASIN: {
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double a = stack.top(); stack.pop();
-                if (a < -1 || a > 1) throw std::invalid_argument("Argument out of range for asin.");
-                stack.push(std::asin(a));
-                break;
-            }
-            case Type::ACOS: {
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double a = stack.top(); stack.pop();
-                if (a < -1 || a > 1) throw std::invalid_argument("Argument out of range for acos.");
-                stack.push(std::acos(a));
-                break;
-            }
-            case Type::ATAN: {
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double a = stack.top(); stack.pop();
-                stack.push(std::atan(a));
-                break;
-            }
+    // Проверка результата
+    T result = stack[temps_];
+    if (std::isnan(result) || std::isinf(result)) {
+        return EvalError{ErrorKind::NOT_FINITE, positions_.back()};
+    }
+    return result;
+}
 
-            case Type::SQRT: {
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double a = stack.top(); stack.pop();
-                if (a < 0) throw std::invalid_argument("Negative argument for sqrt.");
-                stack.push(std::sqrt(a));
-                break;
-            }
+// Проверка структуры программы и расчет максимальной глубины стека
+std::size_t CompiledExpression::stackDepth() const {
+    std::size_t depth = 0, max_depth = 0;
+    for (const Instruction& ins : code_) {
+        int operands = operandCount(ins.type);
+        if (operands < 0) throw std::invalid_argument("Unknown operator type.");
+        if (depth < static_cast<std::size_t>(operands)) throw std::invalid_argument("Invalid expression.");
+        depth = depth - operands + 1;
+        max_depth = std::max(max_depth, depth);
+    }
+    if (depth != 1) throw std::invalid_argument("Invalid expression.");
+    return max_depth;
+}
 
-            case Type::LOG: {
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double a = stack.top(); stack.pop();
-                if (a <= 0) throw std::invalid_argument("Non-positive argument for log.");
-                stack.push(std::log10(a));
-                break;
-            }
+template <class T>
+T CompiledExpression::arithmetic(T a, T b, Type sym, ErrorKind& error) {
+    switch (sym) {
+        case Type::PLUS:
+            return a + b;
+        case Type::MINUS:
+            return a - b;
+        case Type::MULT:
+            return a * b;
+        case Type::DIV:
+            if (b == 0) error = ErrorKind::DIVISION_BY_ZERO;
+            return a / b;
+        case Type::POW:
+            return std::pow(a, b);
+        case Type::MOD:
+            if (b == 0) error = ErrorKind::MODULO_BY_ZERO;
+            return std::fmod(a, b);
+        default:
+            error = ErrorKind::UNKNOWN_OPERATOR;
+            return 0;
+    }
+}
 
-            case Type::LN: {
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double a = stack.top(); stack.pop();
-                if (a <= 0) throw std::invalid_argument("Non-positive argument for ln.");
-                stack.push(std::log(a));
-                break;
-            }
+// Унарные функции и унарный минус
+template <class T>
+T CompiledExpression::trigonometry(T a, Type sym, ErrorKind& error) {
+    switch (sym) {
+        case Type::SIN:
+            return std::sin(a);
+        case Type::COS:
+            return std::cos(a);
+        case Type::TAN:
+            return std::tan(a);
+        case Type::COT: {
+            T tan_a = std::tan(a);
+            if (tan_a == 0) error = ErrorKind::COT_UNDEFINED;
+            return T(1) / tan_a;
+        }
+        case Type::ASIN:
+            if (a < -1 || a > 1) error = ErrorKind::ASIN_DOMAIN;
+            return std::asin(a);
+        case Type::ACOS:
+            if (a < -1 || a > 1) error = ErrorKind::ACOS_DOMAIN;
+            return std::acos(a);
+        case Type::ATAN:
+            return std::atan(a);
+        case Type::SQRT:
+            if (a < 0) error = ErrorKind::SQRT_DOMAIN;
+            return std::sqrt(a);
+        case Type::LOG:
+            if (a <= 0) error = ErrorKind::LOG_DOMAIN;
+            return std::log10(a);
+        case Type::LN:
+            if (a <= 0) error = ErrorKind::LN_DOMAIN;
+            return std::log(a);
+        case Type::UNARY_MINUS:
+            return -a;
+        default:
+            error = ErrorKind::UNKNOWN_OPERATOR;
+            return 0;
+    }
+}
 
-            case Type::UNARY_MINUS: {
-                if (stack.empty()) throw std::invalid_argument("Invalid expression.");
-                double a = stack.top(); stack.pop();
-                stack.push(-a);
-                break;
-            }
+// Вычислитель используется в двух точностях
+template double CompiledExpression::arithmetic<double>(double, double, Type, ErrorKind&);
+template float CompiledExpression::arithmetic<float>(float, float, Type, ErrorKind&);
+template double CompiledExpression::trigonometry<double>(double, Type, ErrorKind&);
+template float CompiledExpression::trigonometry<float>(float, Type, ErrorKind&);
+template double* CompiledExpression::scratch<double>(std::size_t);
+template float* CompiledExpression::scratch<float>(std::size_t);
+template Dual* CompiledExpression::scratch<Dual>(std::size_t);
+template EvalResult CompiledExpression::calcExpression<double>(const double*, double*) const noexcept;
+template EvalResult CompiledExpression::calcExpression<float>(const double*, float*) const noexcept;
 
-            default:
-                throw std::invalid_argument("Unknown operator type.");
+const char* errorMessage(ErrorKind kind) {
+    switch (kind) {
+        case ErrorKind::NONE:
+            return "";
+        case ErrorKind::DIVISION_BY_ZERO:
+            return "Division by zero.";
+        case ErrorKind::MODULO_BY_ZERO:
+            return "Modulo by zero.";
+        case ErrorKind::COT_UNDEFINED:
+            return "Cotangent undefined at this point.";
+        case ErrorKind::ASIN_DOMAIN:
+            return "Argument out of range for asin.";
+        case ErrorKind::ACOS_DOMAIN:
+            return "Argument out of range for acos.";
+        case ErrorKind::SQRT_DOMAIN:
+            return "Negative argument for sqrt.";
+        case ErrorKind::LOG_DOMAIN:
+            return "Non-positive argument for log.";
+        case ErrorKind::LN_DOMAIN:
+            return "Non-positive argument for ln.";
+        case ErrorKind::NOT_FINITE:
+            return "Invalid expression result.";
+        case ErrorKind::BINDING_SIZE:
+            return "Not enough variable bindings.";
+        case ErrorKind::BATCH_SIZE:
+            return "Input and output sizes differ.";
+        case ErrorKind::OUT_OF_MEMORY:
+            return "Not enough memory for evaluation.";
+        default:
+            return "Unknown operator type.";
+    }
+}
+
+// Разбор числа без учета локали и без выделения памяти (кроме редкого
+// случая пробелов внутри числа)
+double SmartCalcModel::parseNumber(std::string_view digits) {
+    std::string compact;
+    if (digits.find(' ') != std::string_view::npos) {
+        for (char ch : digits) {
+            if (ch != ' ') compact += ch;
         }
-        rpn = rpn->next;
+        digits = compact;
+    }
+    double value = 0;
+    auto [ptr, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+    if (ec != std::errc() || ptr != digits.data() + digits.size()) {
+        throw std::invalid_argument("Invalid number in expression.");
     }
+    return value;
+}
 
-    // Проверка результата
-    if (stack.size() != 1) {
-        throw std::invalid_argument("Invalid expression.");
+// Слот переменной с именем name (exact) или самой длинной переменной,
+// имя которой - начало name; variables.size(), если такой нет
+std::size_t SmartCalcModel::matchVariable(std::string_view name, const std::vector<std::string>& variables,
+                                          bool exact) {
+    std::size_t found = variables.size();
+    for (std::size_t k = 0; k < variables.size(); ++k) {
+        if (exact ? name == variables[k] : name.starts_with(variables[k]) &&
+                    (found == variables.size() || variables[k].size() > variables[found].size())) {
+            found = k;
+            if (exact) break;
+        }
     }
-    return stack.top();
+    return found;
 }
 
 // Проверка баланса скобок
-bool SmartCalcModel::checkBrackets(const std::string& expression) {
+bool SmartCalcModel::checkBrackets(std::string_view expression) {
     int balance = 0;
     for (char ch : expression) {
         if (ch == '(') balance++;
@@ -346,19 +463,23 @@ bool SmartCalcModel::checkBrackets(const std::string& expression) {
 }
 
 
-// Добавление элемента в связный список
-void SmartCalcModel::pushBack(std::shared_ptr<Node>& end, double value, Priority priority, Type type) {
-    auto newNode = std::make_shared<Node>(value, priority, type);
-    if (!newNode) throw std::invalid_argument("Failed to create node.");
-    if (!end) {
-        end = newNode;
-    } else {
-        auto temp = end;
-        while (temp->next) {
-            temp = temp->next;
-        }
-        temp->next = newNode;
+// Передача токена лексера в сортировочную станцию
+void SmartCalcModel::pushBack(TokenList& operators, CompiledExpression& compiled, double value,
+                              Priority priority, Type type, std::size_t position) {
+    RPN(operators, compiled, Token{value, priority, type, static_cast<std::uint32_t>(position)});
+}
+
+// Запись инструкции в байт-код; числа попадают в пул констант
+void SmartCalcModel::emit(CompiledExpression& compiled, const Token& token) {
+    std::uint32_t operand = 0;
+    if (token.type == Type::NUMBER) {
+        operand = static_cast<std::uint32_t>(compiled.constants_.size());
+        compiled.constants_.push_back(token.value);
+    } else if (token.type == Type::X) {
+        operand = static_cast<std::uint32_t>(token.value);  // Номер слота переменной
     }
+    compiled.code_.push_back(Instruction{token.type, operand});
+    compiled.positions_.push_back(token.position);
 }
 
 }  // namespace s21
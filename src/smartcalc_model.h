@@ -2,16 +2,23 @@
 #define SMARTCALC_MODEL_H
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
-#include <stack>
+#include <memory_resource>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
+
+#include "smartcalc_thread_pool.h"
 
 namespace s21 {
 
 enum class Type {
     NUMBER,       // Число
-    X,            // Переменная x
+    X,            // Переменная; операнд - номер слота привязки
     PLUS,         // Оператор +
     MINUS,        // Оператор -
     MULT,         // Оператор *
@@ -30,7 +37,9 @@ enum class Type {
     LOG,          // Функция log
     UNARY_MINUS,    // Унарный минус
     ROUNDBRACKET_L, // Открывающая скобка
-    ROUNDBRACKET_R  // Закрывающая скобка
+    ROUNDBRACKET_R, // Закрывающая скобка
+    LOAD,           // Служебная: чтение временного значения
+    STORE           // Служебная: запись вершины стека во временное значение
 };
 
 enum class Priority {
@@ -42,31 +51,301 @@ enum class Priority {
     ROUNDBRACKET = 4 // ()
 };
 
-struct Node {
-    double value;          // Значение числа или оператора
+// Число операндов инструкции: 0 для чисел и x, 1 для функций, 2 для
+// бинарных операторов, -1 для скобок
+constexpr int operandCount(Type type) {
+    switch (type) {
+        case Type::NUMBER:
+        case Type::X:
+        case Type::LOAD:
+            return 0;
+        case Type::PLUS:
+        case Type::MINUS:
+        case Type::MULT:
+        case Type::DIV:
+        case Type::POW:
+        case Type::MOD:
+            return 2;
+        case Type::ROUNDBRACKET_L:
+        case Type::ROUNDBRACKET_R:
+            return -1;
+        default:
+            return 1;
+    }
+}
+
+// Токен входного выражения
+struct Token {
+    double value;          // Значение числа
     Priority priority;     // Приоритет оператора
     Type type;             // Тип элемента (число, оператор, функция и т.д.)
-    std::shared_ptr<Node> next; // Указатель на следующий узел
+    std::uint32_t position;  // Позиция токена в строке выражения
+};
+
+// Стек токенов одного разбора, размещаемый в арене
+using TokenList = std::pmr::vector<Token>;
+
+// Инструкция байт-кода: код операции и операнд
+struct Instruction {
+    Type type;              // Код операции
+    std::uint32_t operand;  // Индекс в пуле констант (NUMBER) или временного значения (LOAD, STORE)
+};
+
+// Вид ошибки вычисления
+enum class ErrorKind : std::uint8_t {
+    NONE,              // Ошибки нет
+    DIVISION_BY_ZERO,  // Деление на ноль
+    MODULO_BY_ZERO,    // Остаток от деления на ноль
+    COT_UNDEFINED,     // Котангенс в нуле тангенса
+    ASIN_DOMAIN,       // Аргумент asin вне [-1, 1]
+    ACOS_DOMAIN,       // Аргумент acos вне [-1, 1]
+    SQRT_DOMAIN,       // Отрицательный аргумент sqrt
+    LOG_DOMAIN,        // Неположительный аргумент log
+    LN_DOMAIN,         // Неположительный аргумент ln
+    NOT_FINITE,        // Результат NaN или бесконечность
+    BINDING_SIZE,      // Привязок меньше, чем переменных в выражении
+    BATCH_SIZE,        // Размеры массивов пакетного вычисления не согласованы
+    UNKNOWN_OPERATOR,  // Неизвестная инструкция
+    OUT_OF_MEMORY      // Не удалось выделить буфер стека вычислений
+};
+
+// Текст ошибки; совпадает с сообщением исключения evaluate
+const char* errorMessage(ErrorKind kind);
+
+// Ошибка вычисления и позиция вызвавшего ее токена в строке выражения
+struct EvalError {
+    ErrorKind kind;
+    std::uint32_t position;
+};
+
+// Результат вычисления без исключений: значение или ошибка (аналог
+// std::expected<double, EvalError>, который появится только в C++23)
+class EvalResult {
+public:
+    EvalResult(double value) : value_(value) {}
+    EvalResult(EvalError error) : value_(std::nan("")), error_(error) {}
+
+    bool has_value() const { return error_.kind == ErrorKind::NONE; }
+    explicit operator bool() const { return has_value(); }
+    // Значение; NaN при ошибке
+    double value() const { return value_; }
+    const EvalError& error() const { return error_; }
+
+private:
+    double value_;
+    EvalError error_{ErrorKind::NONE, 0};
+};
+
+// Отрезок [lo, hi]; lo > hi означает пустое множество
+struct Interval {
+    double lo;
+    double hi;
+
+    bool empty() const { return lo > hi; }
+    bool contains(double value) const { return lo <= value && value <= hi; }
+    double width() const { return hi - lo; }
+};
+
+// Результат интервального вычисления
+struct IntervalResult {
+    // Содержит значение выражения в каждой точке отрезка, где оно определено
+    Interval range;
+    // false - ни в одной точке выражение не определено (отрезок вне области)
+    bool defined;
+    // true - выражение гарантированно определено и конечно во всех точках
+    bool total;
+};
+
+// Значение выражения и его производная по переменной (дуальное число)
+struct Dual {
+    double value;
+    double derivative;
+};
 
-    Node(double val, Priority prio, Type typ)
-        : value(val), priority(prio), type(typ), next(nullptr) {}
-    ~Node() {}
+class JitProgram;
+
+// Точность вычислений скомпилированного выражения
+enum class Precision : std::uint8_t {
+    DOUBLE,  // double (по умолчанию)
+    FLOAT    // float: вдвое больше точек на векторную инструкцию и вдвое меньше памяти
+};
+
+// Параметры компиляции выражения
+struct CompileOptions {
+    bool jit = false;  // Генерировать машинный код x86-64, если платформа позволяет
+    // Имена переменных; индекс имени - номер его слота в массиве привязок.
+    // Пустой список означает единственную переменную x
+    std::vector<std::string> variables = {};
+    // Тип вычислений. Для FLOAT машинный код не генерируется (jit игнорируется);
+    // интервальное вычисление и производные всегда выполняются в double
+    Precision precision = Precision::DOUBLE;
 };
 
+// Скомпилированное выражение: разбор и RPN выполняются один раз,
+// затем выражение вычисляется для любого значения x без повторного разбора.
+// После компиляции выражение не изменяется; вычисление const и реентерабельно,
+// поэтому один объект можно вычислять из многих потоков без синхронизации.
+// Единственное изменяемое состояние - буфер стека, свой у каждого потока
+class CompiledExpression {
+public:
+    // Размер отрезка параллельного вычисления по умолчанию
+    static constexpr std::size_t kDefaultChunkSize = 16384;
+    // Стек до этого размера размещается на стеке вызова
+    static constexpr std::size_t kInlineStackSize = 64;
+
+    CompiledExpression() = default;
+
+    double evaluate(double x_value) const;
+    // Вычисление с привязками переменных: bindings[k] - значение переменной
+    // слота k. Имена переменных разрешены при компиляции
+    double evaluate(std::span<const double> bindings) const;
+    // Вычисление без исключений: ошибка возвращается вместе с позицией токена.
+    // Если не удалось выделить буфер стека, ошибка OUT_OF_MEMORY с позицией 0
+    EvalResult tryEvaluate(double x_value) const noexcept;
+    EvalResult tryEvaluate(std::span<const double> bindings) const noexcept;
+    // Интервальное вычисление: оценка сверху множества значений, когда x
+    // пробегает весь отрезок. Позволяет одним вызовом отбросить область графика,
+    // которая целиком вне области определения, за пределами экрана или плоская
+    IntervalResult evaluateInterval(Interval x_range) const;
+    IntervalResult evaluateInterval(std::span<const Interval> bindings) const;
+    // Значение и производная в одном проходе (автоматическое дифференцирование
+    // вперед). Ошибки области определения - как у evaluate
+    Dual evaluateDerivative(double x_value) const;
+    // Производная по переменной слота variable
+    Dual evaluateDerivative(std::span<const double> bindings, std::size_t variable) const;
+    // То же без исключений: результат пишется в result, ошибка возвращается с
+    // позицией токена (kind == NONE при успехе, при ошибке result - NaN)
+    EvalError tryEvaluateDerivative(double x_value, Dual& result) const noexcept;
+    EvalError tryEvaluateDerivative(std::span<const double> bindings, std::size_t variable,
+                                    Dual& result) const noexcept;
+    // Пакетное дифференцирование: точки вне области определения получают NaN
+    // и valid[i] = 0. Производная может быть бесконечной там, где функция
+    // определена, но не дифференцируема (sqrt(x) в нуле)
+    void evaluateDerivative(std::span<const double> x_values, std::span<double> values,
+                            std::span<double> derivatives, std::span<std::uint8_t> valid = {},
+                            std::size_t variable = 0) const;
+    // Пакетное вычисление: results[i] = f(x_values[i]). Точки вне области
+    // определения не прерывают вычисление: они получают NaN и valid[i] = 0.
+    // Для нескольких переменных x_values - строки по variables() привязок.
+    // results может совпадать с x_values (вычисление на месте)
+    void evaluate(std::span<const double> x_values, std::span<double> results,
+                  std::span<std::uint8_t> valid = {}) const;
+    // То же для массивов float (построение графиков, предпросмотр). Вычисление
+    // идет в точности выражения, без промежуточных массивов double
+    void evaluate(std::span<const float> x_values, std::span<float> results,
+                  std::span<std::uint8_t> valid = {}) const;
+    // Пакетное вычисление с видом ошибки в каждой точке (ErrorKind::NONE, если ее нет).
+    // Не бросает исключений: при несогласованных размерах массивов ничего не
+    // вычисляется и возвращается BATCH_SIZE, при нехватке памяти для буфера -
+    // OUT_OF_MEMORY (результаты не определены), иначе NONE
+    ErrorKind tryEvaluate(std::span<const double> x_values, std::span<double> results,
+                          std::span<ErrorKind> errors) const noexcept;
+    // То же, с разбиением на отрезки по chunk_size точек между потоками пула
+    void evaluateParallel(std::span<const double> x_values, std::span<double> results,
+                          std::span<std::uint8_t> valid = {},
+                          std::size_t chunk_size = kDefaultChunkSize,
+                          ThreadPool& pool = ThreadPool::instance()) const;
+    void evaluateParallel(std::span<const float> x_values, std::span<float> results,
+                          std::span<std::uint8_t> valid = {},
+                          std::size_t chunk_size = kDefaultChunkSize,
+                          ThreadPool& pool = ThreadPool::instance()) const;
+    bool empty() const { return code_.empty(); }
+    // Число инструкций программы
+    std::size_t size() const { return code_.size(); }
+    // Вычисляется ли выражение машинным кодом
+    bool jitted() const { return jit_ != nullptr; }
+    // Число переменных: длина массива привязок одной точки
+    std::size_t variables() const { return variables_; }
+    // Тип, в котором выполняются вычисления
+    Precision precision() const { return precision_; }
+
+private:
+    friend class SmartCalcModel;
+
+    // Операции вычислителя над double или float; ошибка области определения
+    // записывается в error
+    template <class T>
+    static T arithmetic(T a, T b, Type sym, ErrorKind& error);
+    template <class T>
+    static T trigonometry(T a, Type sym, ErrorKind& error);
+
+    // Буфер стека вычислений текущего потока, не меньше size элементов
+    template <class T>
+    static T* scratch(std::size_t size);
+    // Вычисление в точке в типе T; привязки приводятся к T при чтении
+    template <class T>
+    EvalResult calcExpression(const double* bindings, T* stack) const noexcept;
+    EvalError calcDual(const double* bindings, std::size_t variable, Dual* stack,
+                       Dual& result) const noexcept;
+    std::size_t stackDepth() const;
+    // Проверка согласованности размеров массивов пакетного вычисления
+    void checkBatch(std::size_t inputs, std::size_t outputs, std::size_t valid,
+                    std::size_t errors) const;
+    template <class In, class Out>
+    void evaluateBatch(std::span<const In> x_values, std::span<Out> results,
+                       std::span<std::uint8_t> valid, std::span<ErrorKind> errors) const;
+    template <class In, class Out>
+    void evaluateParallelBatch(std::span<const In> x_values, std::span<Out> results,
+                               std::span<std::uint8_t> valid, std::size_t chunk_size,
+                               ThreadPool& pool) const;
+    // Вычисление отрезка точек в точности выражения
+    template <class In, class Out>
+    void calcPoints(std::span<const In> x_values, std::span<Out> results,
+                    std::span<std::uint8_t> valid, std::span<ErrorKind> errors) const;
+    // Вычисление отрезка в типе T; In и Out - типы входного и выходного массивов
+    template <class T, class In, class Out>
+    void calcRange(std::span<const In> x_values, std::span<Out> results,
+                   std::span<std::uint8_t> valid, std::span<ErrorKind> errors, T* stack) const;
+    template <class T>
+    void calcBlock(const T* x_values, T* results, std::uint8_t* invalid, std::size_t lanes,
+                   T* stack) const;
+    template <class T>
+    static void finishBlock(const T* top, T* results, std::uint8_t* invalid, std::size_t lanes);
+
+    std::vector<Instruction> code_;   // Программа в обратной польской записи
+    std::vector<double> constants_;   // Пул констант программы
+    std::vector<std::uint32_t> positions_;  // Позиция токена каждой инструкции в выражении
+    std::size_t temps_ = 0;           // Число временных значений общих подвыражений
+    std::size_t depth_ = 0;           // Максимальная глубина стека, считается при компиляции
+    std::size_t variables_ = 1;       // Число слотов привязок
+    Precision precision_ = Precision::DOUBLE;  // Тип вычислений
+    std::shared_ptr<const JitProgram> jit_;  // Машинный код программы (если собран)
+};
+
+// Модель не хранит состояния: все методы const и могут вызываться из
+// любого числа потоков одновременно
 class SmartCalcModel {
 public:
-    bool isOperator(char ch);
-    double parse(const std::string& expression, double x_value);
+    bool isOperator(char ch) const;
+    CompiledExpression compile(std::string_view expression, const CompileOptions& options = {}) const;
+    double parse(const std::string& expression, double x_value) const;
+    void evaluate(const CompiledExpression& compiled, std::span<const double> x_values,
+                  std::span<double> results, std::span<std::uint8_t> valid = {}) const;
+    void evaluateParallel(const CompiledExpression& compiled, std::span<const double> x_values,
+                          std::span<double> results, std::span<std::uint8_t> valid = {},
+                          std::size_t chunk_size = CompiledExpression::kDefaultChunkSize) const;
+    // Символьная производная порядка order по переменной слота variable,
+    // скомпилированная в такую же программу, как исходное выражение
+    CompiledExpression derivative(const CompiledExpression& compiled, std::size_t order = 1,
+                                  std::size_t variable = 0) const;
 
 private:
-    std::shared_ptr<Node> delimiter(std::shared_ptr<Node> end);
-    std::shared_ptr<Node> RPN(std::shared_ptr<Node> end);
-    double arithmetic(double a, double b, Type sym);
-    double trigonometry(double a, Type sym);
-    double calcExpression(std::shared_ptr<Node> rpn);
-    void pushBack(std::shared_ptr<Node>& end, double value, Priority priority, Type type);
-    bool checkBrackets(const std::string& expression);
-    void lineBreak(std::shared_ptr<Node>& calc, std::string& tmp_str);
+    // Размер встроенного буфера арены разбора (на стеке)
+    static constexpr std::size_t kArenaInlineSize = 4096;
+    // Начальная емкость стека операторов (помещается во встроенный буфер арены)
+    static constexpr std::size_t kInlineOperators = 64;
+
+    static void RPN(TokenList& operators, CompiledExpression& compiled, const Token& token);
+    static void flushOperators(TokenList& operators, CompiledExpression& compiled);
+    static void foldConstants(CompiledExpression& compiled);
+    static void optimizeDag(CompiledExpression& compiled);
+    static void pushBack(TokenList& operators, CompiledExpression& compiled, double value,
+                         Priority priority, Type type, std::size_t position);
+    static void emit(CompiledExpression& compiled, const Token& token);
+    static double parseNumber(std::string_view digits);
+    static std::size_t matchVariable(std::string_view name, const std::vector<std::string>& variables,
+                                     bool exact);
+    static bool checkBrackets(std::string_view expression);
 };
 
 } // namespace s21
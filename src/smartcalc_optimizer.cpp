@@ -0,0 +1,250 @@
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "smartcalc_dag.h"
+#include "smartcalc_jit.h"
+#include "smartcalc_model.h"
+
+namespace s21 {
+
+namespace {
+
+// Значение на моделируемом стеке: начало его кода в новой программе
+// и, если оно не зависит от x, вычисленная константа
+struct FoldValue {
+    std::size_t start;
+    bool constant;
+    double value;
+};
+
+}  // namespace
+
+std::uint32_t ExpressionDag::number(double value, std::uint32_t position) {
+    return intern(Type::NUMBER, kNoOperand, kNoOperand, value, position);
+}
+
+std::uint32_t ExpressionDag::sum(std::uint32_t a, std::uint32_t b, std::uint32_t position) {
+    if (isNumber(a) && isNumber(b)) return number(nodes_[a].value + nodes_[b].value, position);
+    if (isNumber(a, 0)) return b;
+    if (isNumber(b, 0)) return a;
+    return intern(Type::PLUS, a, b, 0, position);
+}
+
+std::uint32_t ExpressionDag::difference(std::uint32_t a, std::uint32_t b, std::uint32_t position) {
+    if (isNumber(a) && isNumber(b)) return number(nodes_[a].value - nodes_[b].value, position);
+    if (isNumber(b, 0)) return a;
+    if (isNumber(a, 0)) return negate(b, position);
+    if (a == b) return number(0, position);
+    return intern(Type::MINUS, a, b, 0, position);
+}
+
+std::uint32_t ExpressionDag::product(std::uint32_t a, std::uint32_t b, std::uint32_t position) {
+    if (isNumber(a) && isNumber(b)) return number(nodes_[a].value * nodes_[b].value, position);
+    if (isNumber(a, 0) || isNumber(b, 0)) return number(0, position);
+    if (isNumber(a, 1)) return b;
+    if (isNumber(b, 1)) return a;
+    if (isNumber(a, -1)) return negate(b, position);
+    if (isNumber(b, -1)) return negate(a, position);
+    return intern(Type::MULT, a, b, 0, position);
+}
+
+std::uint32_t ExpressionDag::quotient(std::uint32_t a, std::uint32_t b, std::uint32_t position) {
+    if (isNumber(a) && isNumber(b) && nodes_[b].value != 0) {
+        return number(nodes_[a].value / nodes_[b].value, position);
+    }
+    if (isNumber(b, 1)) return a;
+    if (isNumber(a, 0)) return number(0, position);
+    return operation(Type::DIV, a, b, position);
+}
+
+std::uint32_t ExpressionDag::negate(std::uint32_t a, std::uint32_t position) {
+    if (isNumber(a)) return number(-nodes_[a].value, position);
+    if (nodes_[a].type == Type::UNARY_MINUS) return nodes_[a].left;
+    return intern(Type::UNARY_MINUS, a, kNoOperand, 0, position);
+}
+
+// Правила дифференцирования; узел id уже вычисляет саму функцию и
+// используется в производной повторно (tan, cot, sqrt, степень)
+std::uint32_t ExpressionDag::derivative(std::uint32_t id, std::uint32_t da, std::uint32_t db) {
+    const DagNode node = nodes_[id];
+    const std::uint32_t a = node.left, b = node.right, p = node.position;
+    switch (node.type) {
+        case Type::PLUS:
+            return sum(da, db, p);
+        case Type::MINUS:
+            return difference(da, db, p);
+        case Type::MULT:
+            return sum(product(da, b, p), product(a, db, p), p);
+        case Type::DIV:
+            // (a/b)' = a'/b - a b' / b^2
+            if (isNumber(db, 0)) return quotient(da, b, p);
+            return difference(quotient(da, b, p), quotient(product(a, db, p), product(b, b, p), p), p);
+        case Type::POW: {
+            // (a^b)' = b a^(b-1) a' + a^b ln(a) b'
+            std::uint32_t by_base = number(0, p), by_exponent = number(0, p);
+            if (!isNumber(da, 0)) {
+                std::uint32_t exponent = difference(b, number(1, p), p);
+                std::uint32_t lowered = isNumber(exponent, 0) ? number(1, p) : operation(Type::POW, a, exponent, p);
+                by_base = product(product(b, lowered, p), da, p);
+            }
+            if (!isNumber(db, 0)) {
+                by_exponent = product(product(id, intern(Type::LN, a, kNoOperand, 0, p), p), db, p);
+            }
+            return sum(by_base, by_exponent, p);
+        }
+        case Type::MOD:
+            // fmod(a, b) = a - trunc(a/b) b, trunc(a/b) = (a - fmod(a, b)) / b
+            if (isNumber(db, 0)) return da;
+            return difference(da, product(quotient(difference(a, id, p), b, p), db, p), p);
+        case Type::SIN:
+            return product(intern(Type::COS, a, kNoOperand, 0, p), da, p);
+        case Type::COS:
+            return negate(product(intern(Type::SIN, a, kNoOperand, 0, p), da, p), p);
+        case Type::TAN:
+            return product(sum(number(1, p), product(id, id, p), p), da, p);
+        case Type::COT:
+            return negate(product(sum(number(1, p), product(id, id, p), p), da, p), p);
+        case Type::ASIN:
+        case Type::ACOS: {
+            std::uint32_t root = intern(Type::SQRT, difference(number(1, p), product(a, a, p), p), kNoOperand, 0, p);
+            std::uint32_t d = quotient(da, root, p);
+            return node.type == Type::ASIN ? d : negate(d, p);
+        }
+        case Type::ATAN:
+            return quotient(da, sum(number(1, p), product(a, a, p), p), p);
+        case Type::SQRT:
+            return quotient(da, product(number(2, p), id, p), p);
+        case Type::LOG:
+            return quotient(da, product(a, number(std::log(10.0), p), p), p);
+        case Type::LN:
+            return quotient(da, a, p);
+        case Type::UNARY_MINUS:
+            return negate(da, p);
+        default:
+            return number(0, p);
+    }
+}
+
+// Операнды созданы раньше родителя, поэтому производные считаются одним
+// проходом по возрастанию номеров узлов, без рекурсии
+void ExpressionDag::differentiate(std::uint32_t variable) {
+    const std::size_t count = static_cast<std::size_t>(root_) + 1;
+    std::vector<std::uint32_t> derivatives(count, kNoOperand);
+    for (std::uint32_t id = 0; id < count; ++id) {
+        const DagNode node = nodes_[id];  // Копия: новые узлы перераспределяют nodes_
+        if (node.type == Type::NUMBER) {
+            derivatives[id] = number(0, node.position);
+        } else if (node.type == Type::X) {
+            derivatives[id] = number(node.value == variable ? 1 : 0, node.position);
+        } else {
+            derivatives[id] = derivative(id, derivatives[node.left],
+                                         node.right == kNoOperand ? number(0, node.position) : derivatives[node.right]);
+        }
+    }
+    root_ = derivatives[root_];
+}
+
+// Свертка констант: каждое поддерево RPN, не зависящее от x, вычисляется
+// при компиляции и заменяется одним NUMBER. Ошибки области определения
+// бросаются теми же исключениями, что и при вычислении
+void SmartCalcModel::foldConstants(CompiledExpression& compiled) {
+    std::vector<Instruction> code;
+    std::vector<double> constants;
+    std::vector<std::uint32_t> positions;
+    std::vector<FoldValue> stack;
+    code.reserve(compiled.code_.size());
+    positions.reserve(compiled.code_.size());
+
+    // Свернутая константа получает позицию вычислившего ее оператора
+    auto pushConstant = [&](std::size_t start, double value, std::uint32_t position) {
+        code.resize(start);
+        positions.resize(start);
+        code.push_back(Instruction{Type::NUMBER, static_cast<std::uint32_t>(constants.size())});
+        positions.push_back(position);
+        constants.push_back(value);
+        stack.push_back(FoldValue{start, true, value});
+    };
+
+    ErrorKind error = ErrorKind::NONE;
+    for (std::size_t i = 0; i < compiled.code_.size(); ++i) {
+        const Instruction& ins = compiled.code_[i];
+        const std::uint32_t position = compiled.positions_[i];
+        int operands = operandCount(ins.type);
+        // Некорректную программу оставляем как есть: ее отвергнет проверка структуры в compile
+        if (operands < 0 || stack.size() < static_cast<std::size_t>(operands)) return;
+
+        if (ins.type == Type::NUMBER) {
+            pushConstant(code.size(), compiled.constants_[ins.operand], position);
+        } else if (operands == 1 && stack.back().constant) {
+            FoldValue a = stack.back();
+            stack.pop_back();
+            pushConstant(a.start, CompiledExpression::trigonometry(a.value, ins.type, error), position);
+        } else if (operands == 2 && stack[stack.size() - 2].constant && stack.back().constant) {
+            FoldValue b = stack.back();
+            stack.pop_back();
+            FoldValue a = stack.back();
+            stack.pop_back();
+            pushConstant(a.start, CompiledExpression::arithmetic(a.value, b.value, ins.type, error), position);
+        } else {
+            std::size_t start = code.size();
+            if (operands > 0) {
+                start = stack[stack.size() - operands].start;
+                stack.resize(stack.size() - operands);
+            }
+            code.push_back(ins);
+            positions.push_back(position);
+            stack.push_back(FoldValue{start, false, 0});
+        }
+        if (error != ErrorKind::NONE) throw std::invalid_argument(errorMessage(error));
+    }
+
+    // Пул констант собирается заново: свернутые промежуточные значения в него не попадают
+    std::vector<double> pool;
+    for (Instruction& ins : code) {
+        if (ins.type == Type::NUMBER) {
+            double value = constants[ins.operand];
+            ins.operand = static_cast<std::uint32_t>(pool.size());
+            pool.push_back(value);
+        }
+    }
+    compiled.code_ = std::move(code);
+    compiled.constants_ = std::move(pool);
+    compiled.positions_ = std::move(positions);
+}
+
+// Оптимизация на графе выражения: понижение стоимости степеней и деления
+// и устранение общих подвыражений. Поддерево, используемое несколько раз,
+// вычисляется один раз и сохраняется во временное значение (STORE), а
+// повторные вхождения заменяются чтением (LOAD)
+void SmartCalcModel::optimizeDag(CompiledExpression& compiled) {
+    ExpressionDag dag;
+    if (!dag.build(compiled.code_, compiled.constants_, compiled.positions_)) return;
+    dag.emit(compiled.code_, compiled.constants_, compiled.positions_, compiled.temps_);
+}
+
+// Символьная производная: граф программы дифференцируется order раз,
+// упрощается и записывается в байт-код. Общие подвыражения функции и
+// производной (sin и cos одного аргумента, сама функция в tan' и sqrt')
+// вычисляются один раз. Машинный код строится, если он был у исходного выражения
+CompiledExpression SmartCalcModel::derivative(const CompiledExpression& compiled, std::size_t order,
+                                              std::size_t variable) const {
+    if (variable >= compiled.variables_) throw std::invalid_argument("Invalid variable index.");
+    CompiledExpression result = compiled;
+    if (compiled.empty() || order == 0) return result;
+
+    ExpressionDag dag;
+    if (!dag.build(compiled.code_, compiled.constants_, compiled.positions_)) {
+        throw std::invalid_argument("Invalid expression.");
+    }
+    for (std::size_t k = 0; k < order; ++k) dag.differentiate(static_cast<std::uint32_t>(variable));
+    dag.emit(result.code_, result.constants_, result.positions_, result.temps_);
+    result.depth_ = result.stackDepth();
+    result.jit_ = nullptr;
+    if (compiled.jitted()) {
+        result.jit_ = JitProgram::compile(result.code_, result.constants_, result.temps_, result.variables_);
+    }
+    return result;
+}
+
+}  // namespace s21
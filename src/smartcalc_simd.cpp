@@ -0,0 +1,627 @@
+#include "smartcalc_simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define S21_SIMD_X86 1
+#endif
+
+namespace s21::simd {
+
+namespace {
+
+template <class T>
+using BinaryKernel = void (*)(Type, const T*, const T*, T*, std::size_t);
+template <class T>
+using UnaryKernel = void (*)(Type, const T*, T*, std::size_t);
+
+// Элементарные функции (SIN, COS, LN, LOG, POW). Ядра записаны один раз на
+// векторных типах GCC и разворачиваются в 4 точки для AVX2 и в 2 точки для
+// SSE2 и остальных процессоров. Операции одни и те же и без FMA, поэтому
+// результат точки не зависит ни от набора инструкций, ни от ее места в блоке.
+// Точки вне основной области (нечисла, |x| > 2^20 у sin и cos, неположительные
+// и денормализованные аргументы логарифма и основания степени, близость к
+// переполнению pow) считаются libm, поэтому ошибки и бесконечности те же.
+// Ошибка на основной области меньше 1 ulp, отличие от glibc не больше 1 ulp
+// (у log10 - 2 ulp: glibc сам ошибается до 1.6 ulp); проверяется в SimdTests
+using Double2 = double __attribute__((vector_size(16)));
+using Double4 = double __attribute__((vector_size(32)));
+
+// Маска сравнения векторов V; она же - целочисленное представление их битов
+template <class V>
+using Bits = decltype(V{} < V{});
+
+// Функции ядер только встраиваются в функции с нужным набором инструкций;
+// векторы передаются по ссылке, иначе для Double4 вне AVX2 менялся бы ABI
+#define S21_SIMD_INLINE __attribute__((always_inline)) inline
+
+bool isElementary(Type op) {
+    return op == Type::SIN || op == Type::COS || op == Type::LN || op == Type::LOG || op == Type::POW;
+}
+
+double elementaryScalar(Type op, double a, double b) {
+    switch (op) {
+        case Type::SIN:
+            return std::sin(a);
+        case Type::COS:
+            return std::cos(a);
+        case Type::LN:
+            return std::log(a);
+        case Type::LOG:
+            return std::log10(a);
+        default:
+            return std::pow(a, b);
+    }
+}
+
+// Арифметика двойной-двойной точности: значение - сумма двух double
+
+// s + e == a + b точно
+template <class V>
+S21_SIMD_INLINE void twoSum(const V& a, const V& b, V& s, V& e) {
+    s = a + b;
+    const V t = s - a;
+    e = (a - (s - t)) + (b - t);
+}
+
+// То же при |a| >= |b|
+template <class V>
+S21_SIMD_INLINE void fastTwoSum(const V& a, const V& b, V& s, V& e) {
+    s = a + b;
+    e = b - (s - a);
+}
+
+// p + e == a * b точно (разбиение Деккера)
+template <class V>
+S21_SIMD_INLINE void twoProduct(const V& a, const V& b, V& p, V& e) {
+    constexpr double kSplit = 134217729.0;  // 2^27 + 1
+    const V ca = a * kSplit, cb = b * kSplit;
+    const V ah = ca - (ca - a), bh = cb - (cb - b);
+    const V al = a - ah, bl = b - bh;
+    p = a * b;
+    e = ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+}
+
+// Ближайшее целое при |x| < 2^51: значение n и оно же в int64
+template <class V>
+S21_SIMD_INLINE void roundToInteger(const V& x, V& n, Bits<V>& i) {
+    constexpr double kShift = 0x1.8p52;
+    const V t = x + kShift;
+    i = (Bits<V>)t - static_cast<std::int64_t>(0x4338000000000000);
+    n = t - kShift;
+}
+
+// sin и cos: приведение x - n pi/2 в двойной-двойной точности (pi/2 из четырех
+// частей, первые три умножаются на n < 2^20 точно), затем многочлены
+// __kernel_sin и __kernel_cos из fdlibm на [-pi/4, pi/4] с учетом хвоста
+template <class V>
+S21_SIMD_INLINE void sinCos(bool cosine, const V& x, V& y, Bits<V>& special) {
+    constexpr double kInvPio2 = 6.36619772367581382433e-01;
+    constexpr double kPio2_1 = 1.57079632673412561417e+00, kPio2_2 = 6.07710050630396597660e-11;
+    constexpr double kPio2_3 = 2.02226624871116645580e-21, kPio2_3t = 8.47842766036889956997e-32;
+    constexpr double kS1 = -1.66666666666666324348e-01, kS2 = 8.33333333332248946124e-03;
+    constexpr double kS3 = -1.98412698298579493134e-04, kS4 = 2.75573137070700676789e-06;
+    constexpr double kS5 = -2.50507602534068634195e-08, kS6 = 1.58969099521155010221e-10;
+    constexpr double kC1 = 4.16666666666666019037e-02, kC2 = -1.38888888888741095749e-03;
+    constexpr double kC3 = 2.48015872894767294178e-05, kC4 = -2.75573143513906633035e-07;
+    constexpr double kC5 = 2.08757232129817482790e-09, kC6 = -1.13596475577881948265e-11;
+
+    const V ax = (V)((Bits<V>)x & INT64_MAX);
+    special = ~(ax <= 0x1p20);
+
+    V n;
+    Bits<V> quadrant;
+    roundToInteger(x * kInvPio2, n, quadrant);
+    const V a = x - n * kPio2_1;  // Точно: n * kPio2_1 точно и близко к x
+    const V w2 = -(n * kPio2_2), w3 = -(n * kPio2_3);
+    V b, be, c, ce, r, rr;
+    twoSum(a, w2, b, be);
+    twoSum(b, w3, c, ce);
+    fastTwoSum(c, (be + ce) - n * kPio2_3t, r, rr);
+
+    const V z = r * r, v = z * r;
+    const V ps = kS2 + z * (kS3 + z * (kS4 + z * (kS5 + z * kS6)));
+    V sine = r - ((z * (0.5 * rr - v * ps) - rr) - v * kS1);
+    // У малых x приведение теряет знак нуля: sin(-0) = -0
+    sine = ax < 0x1p-27 ? x : sine;
+    const V pc = z * (kC1 + z * (kC2 + z * (kC3 + z * (kC4 + z * (kC5 + z * kC6)))));
+    const V hz = 0.5 * z, one_hz = 1.0 - hz;
+    const V cosine_r = one_hz + (((1.0 - one_hz) - hz) + (z * pc - r * rr));
+
+    // cos x = sin(x + pi/2): четверть сдвигается на единицу
+    quadrant += cosine ? 1 : 0;
+    y = (quadrant & 1) != 0 ? cosine_r : sine;
+    y = (V)((Bits<V>)y ^ ((quadrant & 2) << 62));
+}
+
+// ln x и lg x для нормальных x > 0 с ошибкой меньше 1 ulp: e_log.c из fdlibm
+// и e_log10.c из musl. x = 2^k m, m из [sqrt(2)/2, sqrt(2)), f = m - 1
+template <class V>
+S21_SIMD_INLINE void logKernel(bool decimal, const V& x, V& y) {
+    constexpr double kLn2Hi = 6.93147180369123816490e-01, kLn2Lo = 1.90821492927058770002e-10;
+    constexpr double kIvln10Hi = 4.34294481878168880939e-01, kIvln10Lo = 2.50829467116452752298e-11;
+    constexpr double kLog10_2Hi = 3.01029995663611771306e-01, kLog10_2Lo = 3.69423907715893078616e-13;
+    constexpr double kLg1 = 6.666666666666735130e-01, kLg2 = 3.999999999940941908e-01;
+    constexpr double kLg3 = 2.857142874366239149e-01, kLg4 = 2.222219843214978396e-01;
+    constexpr double kLg5 = 1.818357216161805012e-01, kLg6 = 1.531383769920937332e-01;
+    constexpr double kLg7 = 1.479819860511658591e-01;
+    constexpr std::int64_t kOffset = std::int64_t{0x3ff00000 - 0x3fe6a09e} << 32;
+
+    const Bits<V> u = (Bits<V>)x + kOffset;
+    const Bits<V> k = (u >> 52) - 0x3ff;
+    const V m = (V)((u & 0x000fffffffffffff) + (std::int64_t{0x3fe6a09e} << 32));
+    const V f = m - 1.0;
+    const V hfsq = 0.5 * f * f;
+    const V s = f / (2.0 + f);
+    const V z = s * s, w = z * z;
+    const V r = z * (kLg1 + w * (kLg3 + w * (kLg5 + w * kLg7))) + w * (kLg2 + w * (kLg4 + w * kLg6));
+    const V kd = (V)(k + static_cast<std::int64_t>(0x4338000000000000)) - 0x1.8p52;
+    if (!decimal) {
+        y = kd * kLn2Hi - ((hfsq - (s * (hfsq + r) + kd * kLn2Lo)) - f);
+        return;
+    }
+    // f - hfsq делится на старшую часть с 21 битом и остаток
+    const V hi = (V)((Bits<V>)(f - hfsq) & static_cast<std::int64_t>(0xffffffff00000000));
+    const V lo = f - hi - hfsq + s * (hfsq + r);
+    const V val_hi = hi * kIvln10Hi, yk = kd * kLog10_2Hi;
+    const V val_lo = kd * kLog10_2Lo + (lo + hi) * kIvln10Lo + lo * kIvln10Hi;
+    const V sum = yk + val_hi;
+    y = (val_lo + ((yk - sum) + val_hi)) + sum;
+}
+
+// ln x = hi + lo с относительной погрешностью около 2^-64 для нормальных x > 0:
+// x = 2^k m, m из [sqrt(2)/2, sqrt(2)), ln m = 2 atanh(s), s = (m - 1) / (m + 1)
+template <class V>
+S21_SIMD_INLINE void logTwoPart(const V& x, V& hi, V& lo) {
+    constexpr double kLn2Hi = 6.93147180369123816490e-01, kLn2Lo = 1.90821492927058770002e-10;
+    constexpr double kTwoThirdsHi = 0.6666666666666666, kTwoThirdsLo = 3.700743415417188e-17;
+    constexpr std::int64_t kOffset = std::int64_t{0x3ff00000 - 0x3fe6a09e} << 32;
+
+    const Bits<V> u = (Bits<V>)x + kOffset;
+    const Bits<V> k = (u >> 52) - 0x3ff;
+    const V m = (V)((u & 0x000fffffffffffff) + (std::int64_t{0x3fe6a09e} << 32));
+    const V f = m - 1.0;  // Точно
+    const V one = V{} + 1.0;
+    V dh, dl, p, pe;
+    twoSum(m, one, dh, dl);
+    const V sh = f / dh;
+    twoProduct(sh, dh, p, pe);
+    const V sl = (((f - p) - pe) - sh * dl) / dh;
+
+    // 2 atanh(s) = 2s + 2/3 s^3 + s^5 (2/5 + 2/7 s^2 + ...); |s| < 0.1716,
+    // первые два члена считаются в двойной-двойной точности
+    V a, ae, c, ce, g, ge, h, hl;
+    twoProduct(sh, sh, a, ae);
+    twoProduct(a, sh, c, ce);
+    const V cl = ce + ae * sh + 3.0 * a * sl;
+    twoProduct(c, V{} + kTwoThirdsHi, g, ge);
+    const V gl = ge + (cl * kTwoThirdsHi + c * kTwoThirdsLo);
+    const V t = a;
+    const V series =
+        0.4 + t * (2.0 / 7 + t * (2.0 / 9 + t * (2.0 / 11 + t * (2.0 / 13 + t * (2.0 / 15 + t * (2.0 / 17 +
+        t * (2.0 / 19 + t * (2.0 / 21 + t * (2.0 / 23 + t * (2.0 / 25 + t * (2.0 / 27)))))))))));
+    fastTwoSum(2.0 * sh, g, h, hl);
+    const V low = hl + (2.0 * sl + (gl + c * t * series));
+
+    const V kd = (V)(k + static_cast<std::int64_t>(0x4338000000000000)) - 0x1.8p52;
+    V s, se;
+    twoSum(kd * kLn2Hi, h, s, se);
+    fastTwoSum(s, se + (low + kd * kLn2Lo), hi, lo);
+}
+
+// exp(hi + lo) при |hi| <= 708: результат нормален и не переполняется.
+// Приведение по ln 2 и многочлен e_exp.c из fdlibm
+template <class V>
+S21_SIMD_INLINE void expTwoPart(const V& hi, const V& lo, V& y) {
+    constexpr double kInvLn2 = 1.44269504088896338700e+00;
+    constexpr double kLn2Hi = 6.93147180369123816490e-01, kLn2Lo = 1.90821492927058770002e-10;
+    constexpr double kP1 = 1.66666666666666019037e-01, kP2 = -2.77777777770155933842e-03;
+    constexpr double kP3 = 6.61375632143793436117e-05, kP4 = -1.65339022054652515390e-06;
+    constexpr double kP5 = 4.13813679705723846039e-08;
+
+    V n;
+    Bits<V> k;
+    roundToInteger(hi * kInvLn2, n, k);
+    const V rh = hi - n * kLn2Hi;  // Точно
+    const V rl = n * kLn2Lo - lo;
+    const V r = rh - rl;
+    const V t = r * r;
+    const V c = r - t * (kP1 + t * (kP2 + t * (kP3 + t * (kP4 + t * kP5))));
+    const V e = 1.0 - ((rl - (r * c) / (2.0 - c)) - rh);
+    y = e * (V)((k + 0x3ff) << 52);
+}
+
+template <class V>
+S21_SIMD_INLINE void elementary(Type op, const V& a, const V& b, V& y, Bits<V>& special) {
+    constexpr double kMin = std::numeric_limits<double>::min();
+    constexpr double kMax = std::numeric_limits<double>::max();
+    if (op == Type::SIN || op == Type::COS) {
+        sinCos(op == Type::COS, a, y, special);
+        return;
+    }
+    special = ~((a >= kMin) & (a <= kMax));
+    if (op == Type::LN || op == Type::LOG) {
+        logKernel(op == Type::LOG, a, y);
+        return;
+    }
+    // a^b = exp(b ln a); ln a и произведение в двойной-двойной точности
+    V hi, lo, th, te;
+    logTwoPart(a, hi, lo);
+    twoProduct(b, hi, th, te);
+    const V ath = (V)((Bits<V>)th & INT64_MAX), ab = (V)((Bits<V>)b & INT64_MAX);
+    special |= ~((ath <= 708.0) & (ab <= 0x1p900));
+    expTwoPart(th, te + b * lo, y);
+}
+
+// Точки, для которых ядро не подходит, пересчитываются libm
+template <class V>
+S21_SIMD_INLINE void fixSpecial(Type op, const V& x, const V& e, const Bits<V>& special, double* out,
+                                std::size_t lanes) {
+    for (std::size_t k = 0; k < lanes; ++k) {
+        if (special[k]) out[k] = elementaryScalar(op, x[k], e[k]);
+    }
+}
+
+// Применение ядра к массивам. Два вектора за шаг дают независимые цепочки
+// зависимостей; неполный последний вектор дополняется единицами
+template <class V>
+S21_SIMD_INLINE void elementaryArrays(Type op, const double* a, const double* b, double* out, std::size_t n) {
+    constexpr std::size_t kLanes = sizeof(V) / sizeof(double);
+    std::size_t i = 0;
+    for (; i + 2 * kLanes <= n; i += 2 * kLanes) {
+        V x0, x1, e0 = V{} + 1.0, e1 = V{} + 1.0, y0, y1;
+        Bits<V> special0, special1;
+        std::memcpy(&x0, a + i, sizeof(V));
+        std::memcpy(&x1, a + i + kLanes, sizeof(V));
+        if (b) {
+            std::memcpy(&e0, b + i, sizeof(V));
+            std::memcpy(&e1, b + i + kLanes, sizeof(V));
+        }
+        elementary(op, x0, e0, y0, special0);
+        elementary(op, x1, e1, y1, special1);
+        std::memcpy(out + i, &y0, sizeof(V));
+        std::memcpy(out + i + kLanes, &y1, sizeof(V));
+        fixSpecial(op, x0, e0, special0, out + i, kLanes);
+        fixSpecial(op, x1, e1, special1, out + i + kLanes, kLanes);
+    }
+    for (; i + kLanes <= n; i += kLanes) {
+        V x, e = V{} + 1.0, y;
+        Bits<V> special;
+        std::memcpy(&x, a + i, sizeof(V));
+        if (b) std::memcpy(&e, b + i, sizeof(V));
+        elementary(op, x, e, y, special);
+        std::memcpy(out + i, &y, sizeof(V));
+        fixSpecial(op, x, e, special, out + i, kLanes);
+    }
+    if (i < n) {
+        const std::size_t lanes = n - i;
+        V x = V{} + 1.0, e = V{} + 1.0, y;
+        Bits<V> special;
+        std::copy_n(a + i, lanes, reinterpret_cast<double*>(&x));
+        if (b) std::copy_n(b + i, lanes, reinterpret_cast<double*>(&e));
+        elementary(op, x, e, y, special);
+        std::copy_n(reinterpret_cast<const double*>(&y), lanes, out + i);
+        fixSpecial(op, x, e, special, out + i, lanes);
+    }
+}
+
+// float считается в double и округляется: не дальше 1 ulp float от libm
+template <class V>
+S21_SIMD_INLINE void elementaryArrays(Type op, const float* a, const float* b, float* out, std::size_t n) {
+    constexpr std::size_t kChunk = 64;
+    double x[kChunk], e[kChunk];
+    for (std::size_t i = 0; i < n; i += kChunk) {
+        const std::size_t count = std::min(kChunk, n - i);
+        std::copy_n(a + i, count, x);
+        if (b) std::copy_n(b + i, count, e);
+        elementaryArrays<V>(op, x, b ? e : nullptr, x, count);
+        std::transform(x, x + count, out + i, [](double v) { return static_cast<float>(v); });
+    }
+}
+
+// Скалярная реализация; также обрабатывает хвосты векторных циклов
+template <class T>
+void binaryScalar(Type op, const T* a, const T* b, T* out, std::size_t n) {
+    if (isElementary(op)) {
+        elementaryArrays<Double2>(op, a, b, out, n);
+        return;
+    }
+    switch (op) {
+        case Type::PLUS:
+            for (std::size_t i = 0; i < n; ++i) out[i] = a[i] + b[i];
+            break;
+        case Type::MINUS:
+            for (std::size_t i = 0; i < n; ++i) out[i] = a[i] - b[i];
+            break;
+        case Type::MULT:
+            for (std::size_t i = 0; i < n; ++i) out[i] = a[i] * b[i];
+            break;
+        case Type::DIV:
+            for (std::size_t i = 0; i < n; ++i) out[i] = a[i] / b[i];
+            break;
+        default:
+            break;
+    }
+}
+
+template <class T>
+void unaryScalar(Type op, const T* a, T* out, std::size_t n) {
+    if (isElementary(op)) {
+        elementaryArrays<Double2>(op, a, static_cast<const T*>(nullptr), out, n);
+        return;
+    }
+    switch (op) {
+        case Type::SQRT:
+            for (std::size_t i = 0; i < n; ++i) out[i] = std::sqrt(a[i]);
+            break;
+        case Type::UNARY_MINUS:
+            for (std::size_t i = 0; i < n; ++i) out[i] = -a[i];
+            break;
+        default:
+            break;
+    }
+}
+
+#ifdef S21_SIMD_X86
+
+void binarySse2(Type op, const double* a, const double* b, double* out, std::size_t n) {
+    if (isElementary(op)) {
+        elementaryArrays<Double2>(op, a, b, out, n);
+        return;
+    }
+    std::size_t i = 0;
+    switch (op) {
+        case Type::PLUS:
+            for (; i + 2 <= n; i += 2)
+                _mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+            break;
+        case Type::MINUS:
+            for (; i + 2 <= n; i += 2)
+                _mm_storeu_pd(out + i, _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+            break;
+        case Type::MULT:
+            for (; i + 2 <= n; i += 2)
+                _mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+            break;
+        case Type::DIV:
+            for (; i + 2 <= n; i += 2)
+                _mm_storeu_pd(out + i, _mm_div_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+            break;
+        default:
+            break;
+    }
+    binaryScalar(op, a + i, b + i, out + i, n - i);
+}
+
+void unarySse2(Type op, const double* a, double* out, std::size_t n) {
+    if (isElementary(op)) {
+        elementaryArrays<Double2>(op, a, static_cast<const double*>(nullptr), out, n);
+        return;
+    }
+    std::size_t i = 0;
+    switch (op) {
+        case Type::SQRT:
+            for (; i + 2 <= n; i += 2) _mm_storeu_pd(out + i, _mm_sqrt_pd(_mm_loadu_pd(a + i)));
+            break;
+        case Type::UNARY_MINUS: {
+            const __m128d sign = _mm_set1_pd(-0.0);
+            for (; i + 2 <= n; i += 2) _mm_storeu_pd(out + i, _mm_xor_pd(_mm_loadu_pd(a + i), sign));
+            break;
+        }
+        default:
+            break;
+    }
+    unaryScalar(op, a + i, out + i, n - i);
+}
+
+__attribute__((target("avx2"))) void binaryAvx2(Type op, const double* a, const double* b,
+                                                double* out, std::size_t n) {
+    if (isElementary(op)) {
+        elementaryArrays<Double4>(op, a, b, out, n);
+        return;
+    }
+    std::size_t i = 0;
+    switch (op) {
+        case Type::PLUS:
+            for (; i + 4 <= n; i += 4)
+                _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+            break;
+        case Type::MINUS:
+            for (; i + 4 <= n; i += 4)
+                _mm256_storeu_pd(out + i, _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+            break;
+        case Type::MULT:
+            for (; i + 4 <= n; i += 4)
+                _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+            break;
+        case Type::DIV:
+            for (; i + 4 <= n; i += 4)
+                _mm256_storeu_pd(out + i, _mm256_div_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+            break;
+        default:
+            break;
+    }
+    // Сброс верхних половин ymm перед переходом к SSE-коду (libm, хвост)
+    _mm256_zeroupper();
+    binaryScalar(op, a + i, b + i, out + i, n - i);
+}
+
+__attribute__((target("avx2"))) void unaryAvx2(Type op, const double* a, double* out, std::size_t n) {
+    if (isElementary(op)) {
+        elementaryArrays<Double4>(op, a, static_cast<const double*>(nullptr), out, n);
+        return;
+    }
+    std::size_t i = 0;
+    switch (op) {
+        case Type::SQRT:
+            for (; i + 4 <= n; i += 4) _mm256_storeu_pd(out + i, _mm256_sqrt_pd(_mm256_loadu_pd(a + i)));
+            break;
+        case Type::UNARY_MINUS: {
+            const __m256d sign = _mm256_set1_pd(-0.0);
+            for (; i + 4 <= n; i += 4)
+                _mm256_storeu_pd(out + i, _mm256_xor_pd(_mm256_loadu_pd(a + i), sign));
+            break;
+        }
+        default:
+            break;
+    }
+    _mm256_zeroupper();
+    unaryScalar(op, a + i, out + i, n - i);
+}
+
+void binarySse2(Type op, const float* a, const float* b, float* out, std::size_t n) {
+    if (isElementary(op)) {
+        elementaryArrays<Double2>(op, a, b, out, n);
+        return;
+    }
+    std::size_t i = 0;
+    switch (op) {
+        case Type::PLUS:
+            for (; i + 4 <= n; i += 4)
+                _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+            break;
+        case Type::MINUS:
+            for (; i + 4 <= n; i += 4)
+                _mm_storeu_ps(out + i, _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+            break;
+        case Type::MULT:
+            for (; i + 4 <= n; i += 4)
+                _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+            break;
+        case Type::DIV:
+            for (; i + 4 <= n; i += 4)
+                _mm_storeu_ps(out + i, _mm_div_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+            break;
+        default:
+            break;
+    }
+    binaryScalar(op, a + i, b + i, out + i, n - i);
+}
+
+void unarySse2(Type op, const float* a, float* out, std::size_t n) {
+    if (isElementary(op)) {
+        elementaryArrays<Double2>(op, a, static_cast<const float*>(nullptr), out, n);
+        return;
+    }
+    std::size_t i = 0;
+    switch (op) {
+        case Type::SQRT:
+            for (; i + 4 <= n; i += 4) _mm_storeu_ps(out + i, _mm_sqrt_ps(_mm_loadu_ps(a + i)));
+            break;
+        case Type::UNARY_MINUS: {
+            const __m128 sign = _mm_set1_ps(-0.0f);
+            for (; i + 4 <= n; i += 4) _mm_storeu_ps(out + i, _mm_xor_ps(_mm_loadu_ps(a + i), sign));
+            break;
+        }
+        default:
+            break;
+    }
+    unaryScalar(op, a + i, out + i, n - i);
+}
+
+__attribute__((target("avx2"))) void binaryAvx2(Type op, const float* a, const float* b,
+                                                float* out, std::size_t n) {
+    if (isElementary(op)) {
+        elementaryArrays<Double4>(op, a, b, out, n);
+        return;
+    }
+    std::size_t i = 0;
+    switch (op) {
+        case Type::PLUS:
+            for (; i + 8 <= n; i += 8)
+                _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+            break;
+        case Type::MINUS:
+            for (; i + 8 <= n; i += 8)
+                _mm256_storeu_ps(out + i, _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+            break;
+        case Type::MULT:
+            for (; i + 8 <= n; i += 8)
+                _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+            break;
+        case Type::DIV:
+            for (; i + 8 <= n; i += 8)
+                _mm256_storeu_ps(out + i, _mm256_div_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+            break;
+        default:
+            break;
+    }
+    _mm256_zeroupper();
+    binaryScalar(op, a + i, b + i, out + i, n - i);
+}
+
+__attribute__((target("avx2"))) void unaryAvx2(Type op, const float* a, float* out, std::size_t n) {
+    if (isElementary(op)) {
+        elementaryArrays<Double4>(op, a, static_cast<const float*>(nullptr), out, n);
+        return;
+    }
+    std::size_t i = 0;
+    switch (op) {
+        case Type::SQRT:
+            for (; i + 8 <= n; i += 8) _mm256_storeu_ps(out + i, _mm256_sqrt_ps(_mm256_loadu_ps(a + i)));
+            break;
+        case Type::UNARY_MINUS: {
+            const __m256 sign = _mm256_set1_ps(-0.0f);
+            for (; i + 8 <= n; i += 8)
+                _mm256_storeu_ps(out + i, _mm256_xor_ps(_mm256_loadu_ps(a + i), sign));
+            break;
+        }
+        default:
+            break;
+    }
+    _mm256_zeroupper();
+    unaryScalar(op, a + i, out + i, n - i);
+}
+
+#endif  // S21_SIMD_X86
+
+struct Kernels {
+    BinaryKernel<double> binary;
+    UnaryKernel<double> unary;
+    BinaryKernel<float> binary_float;
+    UnaryKernel<float> unary_float;
+    const char* name;
+};
+
+Kernels selectKernels() {
+#ifdef S21_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return {binaryAvx2, unaryAvx2, binaryAvx2, unaryAvx2, "avx2"};
+    if (__builtin_cpu_supports("sse2")) return {binarySse2, unarySse2, binarySse2, unarySse2, "sse2"};
+#endif
+    return {binaryScalar<double>, unaryScalar<double>, binaryScalar<float>, unaryScalar<float>, "scalar"};
+}
+
+const Kernels& kernels() {
+    static const Kernels selected = selectKernels();
+    return selected;
+}
+
+}  // namespace
+
+void binary(Type op, const double* a, const double* b, double* out, std::size_t n) {
+    kernels().binary(op, a, b, out, n);
+}
+
+void unary(Type op, const double* a, double* out, std::size_t n) {
+    kernels().unary(op, a, out, n);
+}
+
+void binary(Type op, const float* a, const float* b, float* out, std::size_t n) {
+    kernels().binary_float(op, a, b, out, n);
+}
+
+void unary(Type op, const float* a, float* out, std::size_t n) {
+    kernels().unary_float(op, a, out, n);
+}
+
+const char* isa() {
+    return kernels().name;
+}
+
+}  // namespace s21::simd
@@ -0,0 +1,30 @@
+#ifndef SMARTCALC_SIMD_H
+#define SMARTCALC_SIMD_H
+
+#include <cstddef>
+
+#include "smartcalc_model.h"
+
+// Векторные ядра для пакетного вычисления.
+// Реализация (AVX2, SSE2 или скалярная) выбирается один раз при первом вызове
+// по возможностям процессора
+namespace s21::simd {
+
+// Поэлементная бинарная операция: out[i] = a[i] op b[i] (PLUS, MINUS, MULT, DIV,
+// POW). POW отличается от std::pow не больше чем на 1 ulp
+void binary(Type op, const double* a, const double* b, double* out, std::size_t n);
+
+// Поэлементная унарная операция: out[i] = op a[i] (SQRT, UNARY_MINUS, SIN, COS,
+// LN, LOG). SIN, COS и LN отличаются от libm не больше чем на 1 ulp, LOG - на 2
+void unary(Type op, const double* a, double* out, std::size_t n);
+
+// Те же операции над float: вдвое больше элементов на инструкцию
+void binary(Type op, const float* a, const float* b, float* out, std::size_t n);
+void unary(Type op, const float* a, float* out, std::size_t n);
+
+// Название выбранного набора инструкций ("avx2", "sse2" или "scalar")
+const char* isa();
+
+}  // namespace s21::simd
+
+#endif  // SMARTCALC_SIMD_H
@@ -0,0 +1,152 @@
+#include "smartcalc_solver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace s21 {
+
+namespace {
+
+// Отрезок сканирования, на котором f меняет знак
+struct Bracket {
+    double a, fa;
+    double b, fb;
+};
+
+}  // namespace
+
+RootSolver::RootSolver(SolverOptions options, ThreadPool& pool) : options_(options), pool_(pool) {
+    options_.samples = std::max<std::size_t>(options_.samples, 1);
+}
+
+SolveResult RootSolver::solve(const CompiledExpression& function, double a, double b) const {
+    if (function.variables() != 1) throw std::invalid_argument("Solver requires a single-variable expression.");
+    if (!std::isfinite(a) || !std::isfinite(b) || a > b) throw std::invalid_argument("Invalid solver interval.");
+
+    SolveResult result;
+    // Сканирование: значения в узлах сетки вычисляются параллельно
+    const std::size_t n = options_.samples;
+    std::vector<double> xs(n + 1), fs(n + 1);
+    std::vector<std::uint8_t> valid(n + 1);
+    for (std::size_t i = 0; i <= n; ++i) xs[i] = i == n ? b : a + (b - a) * i / n;
+    function.evaluateParallel(xs, fs, valid, std::max<std::size_t>(n / (4 * pool_.size()), 256), pool_);
+    result.stats.evaluations = n + 1;
+
+    std::vector<Bracket> brackets;
+    for (std::size_t i = 0; i <= n; ++i) {
+        if (!valid[i]) continue;
+        if (fs[i] == 0) {
+            // Корень в узле сетки
+            if (result.roots.empty() || result.roots.back().x != xs[i]) result.roots.push_back(Root{xs[i], 0, 0, true});
+        } else if (i < n && valid[i + 1] && fs[i + 1] != 0 && std::signbit(fs[i]) != std::signbit(fs[i + 1])) {
+            brackets.push_back(Bracket{xs[i], fs[i], xs[i + 1], fs[i + 1]});
+        }
+    }
+    result.stats.brackets = brackets.size();
+
+    // Уточнение отрезков параллельно; статистика каждого отрезка своя и
+    // складывается по порядку, поэтому результат не зависит от числа потоков
+    std::vector<Root> refined(brackets.size());
+    std::vector<SolverStats> stats(brackets.size());
+    pool_.parallelFor(brackets.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            const Bracket& bracket = brackets[i];
+            refined[i] = refine(function, bracket.a, bracket.fa, bracket.b, bracket.fb, stats[i]);
+        }
+    });
+
+    for (std::size_t i = 0; i < brackets.size(); ++i) {
+        SolverStats& s = stats[i];
+        result.stats.evaluations += s.evaluations;
+        result.stats.iterations += s.iterations;
+        result.stats.newton_steps += s.newton_steps;
+        result.stats.interpolation_steps += s.interpolation_steps;
+        result.stats.bisection_steps += s.bisection_steps;
+        // Смена знака на разрыве: |f| у найденной точки растет, а не убывает
+        const Root& root = refined[i];
+        if (!std::isfinite(root.residual) ||
+            std::abs(root.residual) > std::max(std::abs(brackets[i].fa), std::abs(brackets[i].fb))) {
+            ++result.stats.rejected;
+            continue;
+        }
+        if (!root.converged) ++result.stats.unconverged;
+        result.roots.push_back(root);
+    }
+    std::sort(result.roots.begin(), result.roots.end(), [](const Root& l, const Root& r) { return l.x < r.x; });
+    return result;
+}
+
+// Метод Брента (вариант с флагом бисекции). Кандидат - шаг Ньютона из лучшей
+// точки, если производная в ней известна и отлична от нуля, иначе обратная
+// квадратичная интерполяция или секущая. Кандидат вне условий Брента
+// заменяется делением пополам, поэтому отрезок всегда сходится
+Root RootSolver::refine(const CompiledExpression& function, double a, double fa, double b, double fb,
+                        SolverStats& stats) const {
+    constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+    double da = kNaN, db = kNaN;  // Производные в a и b (NaN - неизвестна)
+    if (std::abs(fa) < std::abs(fb)) {
+        std::swap(a, b);
+        std::swap(fa, fb);
+    }
+    double c = a, fc = fa, d = a;
+    bool bisected = true;
+    std::size_t iteration = 0;
+    for (; iteration < options_.max_iterations; ++iteration) {
+        const double tolerance = options_.tolerance + 2 * std::numeric_limits<double>::epsilon() * std::abs(b);
+        if (fb == 0 || std::abs(b - a) < tolerance) break;
+
+        double s = 0;
+        bool newton = false;
+        if (std::isfinite(db) && db != 0) {
+            s = b - fb / db;
+            newton = true;
+        } else if (fa != fc && fb != fc) {
+            s = a * fb * fc / ((fa - fb) * (fa - fc)) + b * fa * fc / ((fb - fa) * (fb - fc)) +
+                c * fa * fb / ((fc - fa) * (fc - fb));
+        } else {
+            s = b - fb * (b - a) / (fb - fa);
+        }
+
+        const double quarter = (3 * a + b) / 4;
+        const bool outside = !(std::min(quarter, b) < s && s < std::max(quarter, b));
+        const bool slow = bisected ? std::abs(s - b) >= std::abs(b - c) / 2 : std::abs(s - b) >= std::abs(c - d) / 2;
+        const bool tiny = bisected ? std::abs(b - c) < tolerance : std::abs(c - d) < tolerance;
+        if (!std::isfinite(s) || outside || slow || tiny) {
+            s = (a + b) / 2;
+            bisected = true;
+            ++stats.bisection_steps;
+        } else {
+            bisected = false;
+            ++(newton ? stats.newton_steps : stats.interpolation_steps);
+        }
+
+        Dual fs{kNaN, kNaN};
+        ++stats.evaluations;
+        // Точка вне области определения внутри отрезка: уточнение прекращается
+        if (function.tryEvaluateDerivative(s, fs).kind != ErrorKind::NONE) break;
+        d = c;
+        c = b;
+        fc = fb;
+        if (std::signbit(fa) != std::signbit(fs.value)) {
+            b = s;
+            fb = fs.value;
+            db = fs.derivative;
+        } else {
+            a = s;
+            fa = fs.value;
+            da = fs.derivative;
+        }
+        if (std::abs(fa) < std::abs(fb)) {
+            std::swap(a, b);
+            std::swap(fa, fb);
+            std::swap(da, db);
+        }
+    }
+    stats.iterations += iteration;
+    const double tolerance = options_.tolerance + 2 * std::numeric_limits<double>::epsilon() * std::abs(b);
+    return Root{b, fb, iteration, fb == 0 || std::abs(b - a) < tolerance};
+}
+
+}  // namespace s21
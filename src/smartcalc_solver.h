@@ -0,0 +1,66 @@
+#ifndef SMARTCALC_SOLVER_H
+#define SMARTCALC_SOLVER_H
+
+#include <cstddef>
+#include <vector>
+
+#include "smartcalc_model.h"
+#include "smartcalc_thread_pool.h"
+
+namespace s21 {
+
+// Параметры поиска корней
+struct SolverOptions {
+    std::size_t samples = 4096;        // Число отрезков сканирования знака
+    double tolerance = 1e-12;          // Абсолютная точность корня по x
+    std::size_t max_iterations = 100;  // Предел итераций уточнения одного корня
+};
+
+// Найденный корень
+struct Root {
+    double x;
+    double residual;         // f(x)
+    std::size_t iterations;  // Итераций уточнения
+    bool converged;          // Достигнута ли точность за max_iterations
+};
+
+// Статистика поиска
+struct SolverStats {
+    std::size_t evaluations = 0;      // Вычислений f (с производной или без)
+    std::size_t brackets = 0;         // Отрезков со сменой знака
+    std::size_t iterations = 0;       // Итераций уточнения всего
+    std::size_t newton_steps = 0;     // Принятых шагов Ньютона
+    std::size_t interpolation_steps = 0;  // Шагов обратной квадратичной интерполяции и секущих
+    std::size_t bisection_steps = 0;  // Шагов деления пополам
+    std::size_t rejected = 0;         // Смен знака на разрывах (полюсах), а не в корнях
+    std::size_t unconverged = 0;      // Корней, не достигших точности
+};
+
+struct SolveResult {
+    std::vector<Root> roots;  // По возрастанию x
+    SolverStats stats;
+};
+
+// Поиск всех корней f(x) = 0 на отрезке по скомпилированному выражению.
+// Отрезок сканируется пакетным вычислением на пуле потоков; каждая смена знака
+// уточняется методом Брента, в котором интерполяционный шаг заменяется шагом
+// Ньютона по производной из автоматического дифференцирования. Корни четной
+// кратности (касание без смены знака) находятся, только если попали в узел сетки
+class RootSolver {
+public:
+    explicit RootSolver(SolverOptions options = {}, ThreadPool& pool = ThreadPool::instance());
+
+    SolveResult solve(const CompiledExpression& function, double a, double b) const;
+
+private:
+    // Уточнение корня на отрезке [a, b] со сменой знака
+    Root refine(const CompiledExpression& function, double a, double fa, double b, double fb,
+                SolverStats& stats) const;
+
+    SolverOptions options_;
+    ThreadPool& pool_;
+};
+
+}  // namespace s21
+
+#endif  // SMARTCALC_SOLVER_H
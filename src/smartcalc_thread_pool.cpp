@@ -0,0 +1,103 @@
+#include "smartcalc_thread_pool.h"
+
+#include <algorithm>
+
+namespace s21 {
+
+namespace {
+
+// Признак того, что текущий поток уже выполняет задачу пула
+thread_local bool tls_in_pool = false;
+
+}  // namespace
+
+ThreadPool::ThreadPool(std::size_t threads) {
+    std::size_t workers = threads > 1 ? threads - 1 : 0;
+    workers_.reserve(workers);
+    for (std::size_t i = 0; i < workers; ++i) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_) worker.join();
+}
+
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::parallelFor(std::size_t count, std::size_t chunk_size, const RangeFunction& body) {
+    if (count == 0) return;
+    chunk_size = std::max<std::size_t>(chunk_size, 1);
+
+    // Мелкие задачи, вложенные вызовы и занятый пул обслуживаются в текущем потоке
+    std::unique_lock<std::mutex> submit(submit_mutex_, std::defer_lock);
+    if (workers_.empty() || count <= chunk_size || tls_in_pool || !submit.try_lock()) {
+        for (std::size_t begin = 0; begin < count; begin += chunk_size) {
+            body(begin, std::min(count, begin + chunk_size));
+        }
+        return;
+    }
+
+    Job job;
+    job.body = &body;
+    job.count = count;
+    job.chunk_size = chunk_size;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_ = &job;
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    tls_in_pool = true;
+    runChunks(job);
+    tls_in_pool = false;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    job_ = nullptr;  // Опоздавшие рабочие больше не возьмут задачу
+    done_.wait(lock, [&job] { return job.active == 0; });
+    if (job.error) std::rethrow_exception(job.error);
+}
+
+void ThreadPool::workerLoop() {
+    tls_in_pool = true;
+    std::size_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [this, seen] { return stop_ || generation_ != seen; });
+        if (stop_) return;
+        seen = generation_;
+        Job* job = job_;
+        if (!job) continue;
+
+        ++job->active;
+        lock.unlock();
+        runChunks(*job);
+        lock.lock();
+        if (--job->active == 0) done_.notify_all();
+    }
+}
+
+void ThreadPool::runChunks(Job& job) {
+    while (true) {
+        std::size_t begin = job.next.fetch_add(job.chunk_size);
+        if (begin >= job.count) return;
+        try {
+            (*job.body)(begin, std::min(job.count, begin + job.chunk_size));
+        } catch (...) {
+            job.next.store(job.count);  // Оставшиеся отрезки не обрабатываются
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!job.error) job.error = std::current_exception();
+        }
+    }
+}
+
+}  // namespace s21
@@ -0,0 +1,64 @@
+#ifndef SMARTCALC_THREAD_POOL_H
+#define SMARTCALC_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace s21 {
+
+// Постоянный пул потоков для параллельных пакетных вычислений.
+// Вызывающий поток участвует в работе наравне с рабочими
+class ThreadPool {
+public:
+    // Тело параллельного цикла: обработка отрезка [begin, end)
+    using RangeFunction = std::function<void(std::size_t begin, std::size_t end)>;
+
+    explicit ThreadPool(std::size_t threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Общий пул библиотеки на все ядра процессора
+    static ThreadPool& instance();
+
+    // Число потоков, включая вызывающий
+    std::size_t size() const { return workers_.size() + 1; }
+
+    // Разбивает [0, count) на отрезки по chunk_size и выполняет body для каждого.
+    // Возвращает управление после обработки всех отрезков; первое исключение
+    // из body пробрасывается вызывающему. Вложенные вызовы выполняются последовательно
+    void parallelFor(std::size_t count, std::size_t chunk_size, const RangeFunction& body);
+
+private:
+    struct Job {
+        const RangeFunction* body;
+        std::size_t count;
+        std::size_t chunk_size;
+        std::atomic<std::size_t> next{0};  // Начало следующего свободного отрезка
+        std::size_t active = 0;            // Рабочие, взявшие задачу (под mutex_)
+        std::exception_ptr error;          // Первое исключение (под mutex_)
+    };
+
+    void workerLoop();
+    void runChunks(Job& job);
+
+    std::vector<std::thread> workers_;
+    std::mutex submit_mutex_;  // Одна параллельная задача за раз
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    Job* job_ = nullptr;
+    std::size_t generation_ = 0;
+    bool stop_ = false;
+};
+
+}  // namespace s21
+
+#endif  // SMARTCALC_THREAD_POOL_H
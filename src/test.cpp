@@ -1,6 +1,48 @@
 #include <gtest/gtest.h>
+#include <atomic>
+#include <bit>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#include "smartcalc_controller.h"
+#include "smartcalc_ct_expr.h"
+#include "smartcalc_integrator.h"
+#include "smartcalc_jit.h"
+#include "smartcalc_keywords.h"
 #include "smartcalc_model.h"
+#include "smartcalc_simd.h"
+#include "smartcalc_solver.h"
+#include "smartcalc_thread_pool.h"
+
+// Счетчик выделений памяти для AllocationTests
+static std::atomic<std::size_t> allocated_bytes{0};
+// Отказ в выделении памяти в потоке теста (проверка нехватки памяти)
+static thread_local bool fail_allocations = false;
+
+void* operator new(std::size_t size) {
+  allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  if (fail_allocations) throw std::bad_alloc();
+  if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+// Расстояние в ulp между числами одного типа; два нечисла совпадают
+template <class T>
+static std::int64_t ulpDistance(T a, T b) {
+  if (std::isnan(a) || std::isnan(b)) return std::isnan(a) && std::isnan(b) ? 0 : INT64_MAX;
+  auto ordered = [](T v) {
+    std::conditional_t<sizeof(T) == 8, std::int64_t, std::int32_t> bits;
+    std::memcpy(&bits, &v, sizeof(v));
+    return bits < 0 ? std::numeric_limits<decltype(bits)>::min() - static_cast<std::int64_t>(bits)
+                    : static_cast<std::int64_t>(bits);
+  };
+  return std::abs(ordered(a) - ordered(b));
+}
 
 TEST(BaseTests, Test0) {
   char str[64] = "2+2*2";
@@ -363,3 +405,1420 @@ TEST(EdgeTests, Test2) {
   res = calc.parse(str, 0);
   EXPECT_DOUBLE_EQ(res, 5);
 }
+
+TEST(CompiledTests, Test0) {
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression expr = calc.compile("2*x+1");
+  EXPECT_DOUBLE_EQ(expr.evaluate(0), 1);
+  EXPECT_DOUBLE_EQ(expr.evaluate(2), 5);
+  EXPECT_DOUBLE_EQ(expr.evaluate(-3), -5);
+}
+
+TEST(CompiledTests, Test1) {
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression expr = calc.compile("(sin(x))^2+(cos(x))^2");
+  for (double x = -5; x <= 5; x += 0.25) {
+    EXPECT_NEAR(expr.evaluate(x), 1, 1e-12);
+    EXPECT_DOUBLE_EQ(expr.evaluate(x), calc.parse("(sin(x))^2+(cos(x))^2", x));
+  }
+}
+
+TEST(CompiledTests, Test2) {
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression expr = calc.compile("sqrt(x)");
+  EXPECT_DOUBLE_EQ(expr.evaluate(4), 2);
+  EXPECT_THROW(expr.evaluate(-1), std::invalid_argument);
+  EXPECT_DOUBLE_EQ(expr.evaluate(9), 3);
+}
+
+TEST(CompiledTests, Test3) {
+  s21::SmartCalcModel calc;
+  EXPECT_THROW(calc.compile("(2+x"), std::invalid_argument);
+  EXPECT_THROW(calc.compile("2+y"), std::invalid_argument);
+}
+
+TEST(LargeTests, Test0) {
+  std::string str = "1";
+  for (int i = 0; i < 100000; ++i) str += "+x";
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression expr = calc.compile(str);
+  EXPECT_DOUBLE_EQ(expr.evaluate(2), 200001);
+}
+
+TEST(LargeTests, Test1) {
+  std::string str(50000, '(');
+  str += "x";
+  str += std::string(50000, ')');
+  s21::SmartCalcModel calc;
+  EXPECT_DOUBLE_EQ(calc.parse(str, 7), 7);
+}
+
+TEST(BatchTests, Test0) {
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression expr = calc.compile("x^2-3*x+1");
+  std::vector<double> xs = {-2, -1, 0, 0.5, 1, 2, 10};
+  std::vector<double> ys(xs.size());
+  calc.evaluate(expr, xs, ys);
+  for (std::size_t i = 0; i < xs.size(); ++i) {
+    EXPECT_DOUBLE_EQ(ys[i], expr.evaluate(xs[i]));
+  }
+}
+
+TEST(BatchTests, Test1) {
+  s21::SmartCalcController controller;
+  s21::CompiledExpression expr = controller.compileExpression("sin(x)+cos(x)");
+  std::vector<double> xs(1000);
+  for (std::size_t i = 0; i < xs.size(); ++i) xs[i] = i * 0.01;
+  std::vector<double> ys(xs.size());
+  controller.calculateBatch(expr, xs, ys);
+  // Векторные sin и cos отличаются от libm не больше чем на 1 ulp
+  for (std::size_t i = 0; i < xs.size(); ++i) {
+    EXPECT_NEAR(ys[i], std::sin(xs[i]) + std::cos(xs[i]), 1e-15);
+  }
+}
+
+TEST(BatchTests, Test2) {
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression expr = calc.compile("ln(x)");
+  std::vector<double> xs = {1, 2, -1};
+  std::vector<double> ys(xs.size());
+  std::vector<std::uint8_t> valid(xs.size());
+  calc.evaluate(expr, xs, ys, valid);
+  EXPECT_DOUBLE_EQ(ys[1], std::log(2));
+  EXPECT_TRUE(std::isnan(ys[2]));
+  EXPECT_EQ(valid, (std::vector<std::uint8_t>{1, 1, 0}));
+  std::vector<double> short_ys(2);
+  EXPECT_THROW(calc.evaluate(expr, xs, short_ys), std::invalid_argument);
+}
+
+TEST(BatchTests, Test3) {
+  const char* exprs[] = {"x+2*x-x/3", "sqrt(x)", "ln(x)+log(x)", "asin(x)+acos(x)",
+                         "atan(x)*tan(x)", "cot(x)", "1/x", "x mod 0.7", "(-x)^3",
+                         "sin(x)-cos(x)", "2^x"};
+  s21::SmartCalcModel calc;
+  std::vector<double> xs(1000);
+  for (std::size_t i = 0; i < xs.size(); ++i) xs[i] = -2.5 + i * 0.005;
+  for (const char* str : exprs) {
+    s21::CompiledExpression expr = calc.compile(str);
+    std::vector<double> ys(xs.size());
+    std::vector<std::uint8_t> valid(xs.size());
+    expr.evaluate(xs, ys, valid);
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+      try {
+        double expected = expr.evaluate(xs[i]);
+        EXPECT_EQ(valid[i], 1) << str << " x=" << xs[i];
+        EXPECT_NEAR(ys[i], expected, 1e-15 * std::max(1.0, std::fabs(expected))) << str << " x=" << xs[i];
+      } catch (const std::invalid_argument&) {
+        EXPECT_EQ(valid[i], 0) << str << " x=" << xs[i];
+        EXPECT_TRUE(std::isnan(ys[i])) << str << " x=" << xs[i];
+      }
+    }
+  }
+}
+
+TEST(BatchTests, Test4) {
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression expr = calc.compile("sqrt(x-1)+1");
+  std::vector<double> xs = {0, 1, 5, -3, 10};
+  std::vector<double> ys(xs.size());
+  calc.evaluate(expr, xs, ys);
+  EXPECT_TRUE(std::isnan(ys[0]));
+  EXPECT_DOUBLE_EQ(ys[1], 1);
+  EXPECT_DOUBLE_EQ(ys[2], 3);
+  EXPECT_TRUE(std::isnan(ys[3]));
+  EXPECT_DOUBLE_EQ(ys[4], 4);
+}
+
+TEST(ParallelTests, Test0) {
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression expr = calc.compile("sqrt(x)*sin(x)+ln(x)");
+  std::vector<double> xs(100000);
+  for (std::size_t i = 0; i < xs.size(); ++i) xs[i] = -10 + i * 0.001;
+  std::vector<double> expected(xs.size());
+  std::vector<std::uint8_t> expected_valid(xs.size());
+  expr.evaluate(xs, expected, expected_valid);
+  for (std::size_t threads : {1, 2, 3, 8}) {
+    s21::ThreadPool pool(threads);
+    for (std::size_t chunk : {1, 255, 1000, 65536}) {
+      std::vector<double> ys(xs.size());
+      std::vector<std::uint8_t> valid(xs.size());
+      expr.evaluateParallel(xs, ys, valid, chunk, pool);
+      EXPECT_EQ(valid, expected_valid);
+      EXPECT_EQ(std::memcmp(ys.data(), expected.data(), ys.size() * sizeof(double)), 0);
+    }
+  }
+}
+
+TEST(ParallelTests, Test1) {
+  s21::SmartCalcController controller;
+  s21::CompiledExpression expr = controller.compileExpression("x*x");
+  std::vector<double> xs(50000, 3), ys(xs.size());
+  controller.calculateBatchParallel(expr, xs, ys);
+  for (double y : ys) EXPECT_DOUBLE_EQ(y, 9);
+}
+
+TEST(ParallelTests, Test2) {
+  s21::ThreadPool pool(4);
+  std::vector<int> hits(10000);
+  pool.parallelFor(hits.size(), 7, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) ++hits[i];
+    pool.parallelFor(3, 1, [](std::size_t, std::size_t) {});
+  });
+  for (int hit : hits) EXPECT_EQ(hit, 1);
+  EXPECT_THROW(pool.parallelFor(100, 1,
+                                [](std::size_t begin, std::size_t) {
+                                  if (begin == 50) throw std::invalid_argument("chunk");
+                                }),
+               std::invalid_argument);
+}
+
+TEST(CacheTests, Test0) {
+  s21::SmartCalcController controller;
+  EXPECT_DOUBLE_EQ(controller.calculateExpression("2*x+1", 1), 3);
+  EXPECT_DOUBLE_EQ(controller.calculateExpression("2 * x + 1", 2), 5);
+  EXPECT_DOUBLE_EQ(controller.calculateExpression(" 2*x +1 ", 3), 7);
+  s21::ExpressionCache::Stats stats = controller.cacheStats();
+  EXPECT_EQ(stats.misses, 1u);
+  EXPECT_EQ(stats.hits, 2u);
+  EXPECT_EQ(stats.size, 1u);
+}
+
+TEST(CacheTests, Test1) {
+  s21::SmartCalcController controller(2);
+  controller.calculateExpression("x+1", 0);
+  controller.calculateExpression("x+2", 0);
+  controller.calculateExpression("x+1", 0);  // x+1 становится самым свежим
+  controller.calculateExpression("x+3", 0);  // вытесняет x+2
+  controller.calculateExpression("x+1", 0);
+  s21::ExpressionCache::Stats stats = controller.cacheStats();
+  EXPECT_EQ(stats.misses, 3u);
+  EXPECT_EQ(stats.hits, 2u);
+  EXPECT_EQ(stats.evictions, 1u);
+  EXPECT_EQ(stats.size, 2u);
+  EXPECT_DOUBLE_EQ(controller.calculateExpression("x+2", 1), 3);
+  EXPECT_EQ(controller.cacheStats().misses, 4u);
+}
+
+TEST(CacheTests, Test2) {
+  auto calc = std::make_shared<const s21::SmartCalcModel>();
+  s21::SmartCalcController controller(calc);
+  EXPECT_DOUBLE_EQ(controller.calculateExpression("2 - -3", 0), 5);
+  EXPECT_DOUBLE_EQ(calc->parse("2 - -3", 0), 5);
+  EXPECT_THROW(controller.calculateExpression("", 0), std::invalid_argument);
+  EXPECT_THROW(controller.calculateExpression("ln(x)", -1), std::invalid_argument);
+  EXPECT_THROW(controller.calculateExpression("(2+3", 0), std::invalid_argument);
+  EXPECT_EQ(controller.cacheStats().size, 2u);
+}
+
+TEST(CacheTests, Test3) {
+  const s21::SmartCalcController controller(8);
+  std::vector<std::thread> threads;
+  std::atomic<int> failures{0};
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&controller, &failures, t] {
+      for (int i = 0; i < 2000; ++i) {
+        int k = (i + t) % 12;
+        std::string str = "x*" + std::to_string(k);
+        if (controller.calculateExpression(str, 2) != 2.0 * k) ++failures;
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_EQ(failures, 0);
+  s21::ExpressionCache::Stats stats = controller.cacheStats();
+  EXPECT_EQ(stats.hits + stats.misses, 16000u);
+  EXPECT_LE(stats.size, 8u);
+}
+
+TEST(CacheTests, Test4) {
+  // Пробел внутри ключевого слова не выбрасывается из ключа: такие выражения
+  // ошибочны, как и в parse(), даже если слитная запись уже в кэше
+  s21::SmartCalcController controller;
+  s21::SmartCalcModel calc;
+  EXPECT_DOUBLE_EQ(controller.calculateExpression("sin(1)", 0), std::sin(1));
+  EXPECT_DOUBLE_EQ(controller.calculateExpression("2 mod 3", 0), 2);
+  for (const char* str : {"s in(1)", "2 m od 3", "x m od 2"}) {
+    EXPECT_THROW(calc.parse(str, 1), std::invalid_argument) << str;
+    EXPECT_THROW(controller.calculateExpression(str, 1), std::invalid_argument) << str;
+  }
+  EXPECT_DOUBLE_EQ(controller.calculateExpression("2  mod   3", 0), 2);
+  EXPECT_EQ(controller.cacheStats().hits, 1u);
+  EXPECT_EQ(s21::ExpressionCache::normalize(" x 1 + 2 mod 3 "), "x 1+2 mod 3");
+}
+
+TEST(CacheTests, Test5) {
+  // Позиции ошибок отсчитываются в исходном тексте, а не в ключе кэша
+  s21::SmartCalcController controller;
+  s21::SmartCalcModel calc;
+  EXPECT_THROW(controller.calculateExpression("1/(x-1)", 1), std::invalid_argument);
+  for (const char* str : {"   1 / (x - 1)", "1/(x-1)", "1 /(x-1)"}) {
+    s21::EvalResult expected = calc.compile(str).tryEvaluate(1);
+    s21::EvalResult actual = controller.compileExpression(str).tryEvaluate(1);
+    ASSERT_FALSE(actual.has_value());
+    EXPECT_EQ(actual.error().kind, s21::ErrorKind::DIVISION_BY_ZERO);
+    EXPECT_EQ(actual.error().position, expected.error().position) << str;
+  }
+  EXPECT_EQ(controller.compileExpression("   1 / (x - 1)").tryEvaluate(1).error().position, 5u);
+}
+
+TEST(FoldingTests, Test0) {
+  s21::SmartCalcModel calc;
+  EXPECT_EQ(calc.compile("(3+1)*4").size(), 1u);
+  EXPECT_EQ(calc.compile("sin(2)*sqrt(16)").size(), 1u);
+  EXPECT_EQ(calc.compile("x*((3+1)*4)").size(), 3u);
+  EXPECT_EQ(calc.compile("x*(3+1)*4").size(), 5u);
+  EXPECT_EQ(calc.compile("sin(x)").size(), 2u);
+}
+
+TEST(FoldingTests, Test1) {
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression expr = calc.compile("x*(3+1)*4+sin(2)*sqrt(16)-ln(x)");
+  EXPECT_DOUBLE_EQ(expr.evaluate(2), 2.0 * 4 * 4 + std::sin(2.0) * 4 - std::log(2.0));
+  EXPECT_DOUBLE_EQ(calc.compile("-(2^10)mod 7").evaluate(0), std::fmod(-1024.0, 7));
+}
+
+TEST(FoldingTests, Test2) {
+  s21::SmartCalcModel calc;
+  EXPECT_THROW(calc.compile("x+1/0"), std::invalid_argument);
+  EXPECT_THROW(calc.compile("x*sqrt(-4)"), std::invalid_argument);
+  EXPECT_THROW(calc.compile("log(0)+x"), std::invalid_argument);
+  EXPECT_THROW(calc.compile("asin(2)*x"), std::invalid_argument);
+  EXPECT_THROW(calc.parse("x mod 0", 1), std::invalid_argument);
+  EXPECT_THROW(calc.parse("10^400", 0), std::invalid_argument);
+}
+
+TEST(CseTests, Test0) {
+  s21::SmartCalcModel calc;
+  // x sin STORE LOAD * x cos LOAD * + вместо 11 инструкций с тремя sin
+  s21::CompiledExpression expr = calc.compile("(sin(x))*(sin(x))+cos(x)*(sin(x))");
+  EXPECT_EQ(expr.size(), 10u);
+  for (double x = -3; x <= 3; x += 0.1) {
+    EXPECT_DOUBLE_EQ(expr.evaluate(x), std::sin(x) * std::sin(x) + std::cos(x) * std::sin(x));
+  }
+}
+
+TEST(CseTests, Test1) {
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression expr = calc.compile("sqrt(x*x+1)/(x*x+1)");
+  std::vector<double> xs(600), ys(xs.size());
+  for (std::size_t i = 0; i < xs.size(); ++i) xs[i] = -3 + i * 0.01;
+  expr.evaluate(xs, ys);
+  for (std::size_t i = 0; i < xs.size(); ++i) {
+    double t = xs[i] * xs[i] + 1;
+    EXPECT_DOUBLE_EQ(ys[i], std::sqrt(t) / t);
+    EXPECT_DOUBLE_EQ(expr.evaluate(xs[i]), std::sqrt(t) / t);
+  }
+}
+
+TEST(CseTests, Test2) {
+  s21::SmartCalcModel calc;
+  EXPECT_EQ(calc.compile("(x+1)*(1+x)").size(), calc.compile("(x+1)*(x+1)").size());
+  EXPECT_DOUBLE_EQ(calc.parse("(x-1)/(1-x)+ln(x)*ln(x)", 2), -1 + std::log(2) * std::log(2));
+  EXPECT_THROW(calc.parse("sqrt(x)+sqrt(x)", -1), std::invalid_argument);
+}
+
+TEST(StrengthTests, Test0) {
+  s21::SmartCalcModel calc;
+  EXPECT_EQ(calc.compile("x^2").size(), 3u);        // x x *
+  EXPECT_EQ(calc.compile("x^4").size(), 6u);        // x x * STORE LOAD *
+  EXPECT_EQ(calc.compile("x^1").size(), 1u);        // x
+  EXPECT_EQ(calc.compile("(x*x+1)^0.5").size(), 6u);  // x x * 1 + sqrt
+  EXPECT_EQ(calc.compile("(x+1)^0.5").size(), 5u);    // x 1 + 0.5 ^: основание бывает < 0
+  EXPECT_EQ(calc.compile("x^2.5").size(), 3u);      // x 2.5 ^
+}
+
+TEST(StrengthTests, Test1) {
+  struct Case {
+    const char* str;
+    double (*expected)(double);
+  };
+  const Case cases[] = {
+      {"x^2", [](double x) { return std::pow(x, 2); }},
+      {"x^3", [](double x) { return std::pow(x, 3); }},
+      {"x^4", [](double x) { return std::pow(x, 4); }},
+      {"x^0.5", [](double x) { return std::pow(x, 0.5); }},
+      {"(x-1)^3+x^2", [](double x) { return std::pow(x - 1, 3) + std::pow(x, 2); }},
+      {"x/4", [](double x) { return x / 4; }},
+      {"x/0.125", [](double x) { return x / 0.125; }},
+      {"x/3", [](double x) { return x / 3; }},
+  };
+  s21::SmartCalcModel calc;
+  for (const Case& c : cases) {
+    s21::CompiledExpression expr = calc.compile(c.str);
+    for (double x = 0.1; x < 50; x *= 1.37) {
+      EXPECT_DOUBLE_EQ(expr.evaluate(x), c.expected(x)) << c.str << " x=" << x;
+    }
+  }
+}
+
+TEST(StrengthTests, Test2) {
+  s21::SmartCalcModel calc;
+  EXPECT_THROW(calc.parse("x^0.5", -4), std::invalid_argument);
+  // x^0.5 остается степенью: та же ошибка, что у pow, и pow(-0, 0.5) = +0
+  s21::EvalResult negative = calc.compile("1+x^0.5").tryEvaluate(-4);
+  EXPECT_EQ(negative.error().kind, s21::ErrorKind::NOT_FINITE);
+  EXPECT_EQ(negative.error().position, 1u);
+  EXPECT_FALSE(std::signbit(calc.parse("x^0.5", -0.0)));
+  EXPECT_EQ(calc.parse("(x*x)^0.5", -3), 3);
+  EXPECT_THROW(calc.parse("x/0", 1), std::invalid_argument);
+  EXPECT_DOUBLE_EQ(calc.parse("x/8", 3), 0.375);
+}
+
+TEST(SimdTests, Test0) {
+  // Векторные sin, cos, ln, log и pow против libm: не дальше 1 ulp (log10
+  // из glibc сам ошибается до 2 ulp); особые значения совпадают побитово
+  std::vector<double> xs, ys;
+  for (int i = 0; i < 20000; ++i) {
+    const double t = std::fmod(i * 0.6180339887498949, 1.0);
+    xs.push_back(i % 2 ? std::pow(10.0, 40 * t - 20) : 200 * t - 100);
+    ys.push_back(std::fmod(i * 0.7548776662466927, 1.0) * 60 - 30);
+  }
+  for (double special : {0.0, -0.0, 1.0, -1.0, 1e-310, 1e300, -1e300, 1e7, HUGE_VAL, -HUGE_VAL, std::nan("")}) {
+    xs.push_back(special);
+    ys.push_back(special);
+    xs.push_back(special);
+    ys.push_back(0.5);
+  }
+  const std::pair<s21::Type, double (*)(double)> unary[] = {
+      {s21::Type::SIN, [](double a) { return std::sin(a); }},
+      {s21::Type::COS, [](double a) { return std::cos(a); }},
+      {s21::Type::LN, [](double a) { return std::log(a); }},
+      {s21::Type::LOG, [](double a) { return std::log10(a); }}};
+  std::vector<double> out(xs.size());
+  for (auto [op, function] : unary) {
+    s21::simd::unary(op, xs.data(), out.data(), xs.size());
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+      EXPECT_LE(ulpDistance(out[i], function(xs[i])), op == s21::Type::LOG ? 2 : 1) << xs[i];
+    }
+  }
+  s21::simd::binary(s21::Type::POW, xs.data(), ys.data(), out.data(), xs.size());
+  for (std::size_t i = 0; i < xs.size(); ++i) {
+    EXPECT_LE(ulpDistance(out[i], std::pow(xs[i], ys[i])), 1) << xs[i] << " " << ys[i];
+  }
+  const double base = -2, exponent = 3;
+  s21::simd::binary(s21::Type::POW, &base, &exponent, out.data(), 1);
+  EXPECT_EQ(out[0], -8.0);
+}
+
+TEST(SimdTests, Test1) {
+  // Результат точки не зависит от ее места в массиве (хвост дополняется),
+  // float считается через double и не дальше 1 ulp float от libm
+  std::vector<double> xs(37);
+  for (std::size_t i = 0; i < xs.size(); ++i) xs[i] = 0.37 * i - 5;
+  std::vector<double> all(xs.size());
+  s21::simd::unary(s21::Type::SIN, xs.data(), all.data(), xs.size());
+  for (std::size_t i = 0; i < xs.size(); ++i) {
+    double single = 0;
+    s21::simd::unary(s21::Type::SIN, &xs[i], &single, 1);
+    EXPECT_EQ(std::memcmp(&single, &all[i], sizeof(double)), 0) << xs[i];
+  }
+  std::vector<float> fs(1000), fout(fs.size()), fexp(fs.size(), 1.5f);
+  for (std::size_t i = 0; i < fs.size(); ++i) fs[i] = 0.013f * static_cast<float>(i) + 0.001f;
+  s21::simd::unary(s21::Type::COS, fs.data(), fout.data(), fs.size());
+  for (std::size_t i = 0; i < fs.size(); ++i) EXPECT_LE(ulpDistance(fout[i], std::cos(fs[i])), 1);
+  s21::simd::unary(s21::Type::LN, fs.data(), fout.data(), fs.size());
+  for (std::size_t i = 0; i < fs.size(); ++i) EXPECT_LE(ulpDistance(fout[i], std::log(fs[i])), 1);
+  s21::simd::binary(s21::Type::POW, fs.data(), fexp.data(), fout.data(), fs.size());
+  for (std::size_t i = 0; i < fs.size(); ++i) EXPECT_LE(ulpDistance(fout[i], std::pow(fs[i], 1.5f)), 1);
+}
+
+TEST(JitTests, Test0) {
+  // Машинный код совпадает с интерпретатором побитово (0 ulp)
+  const char* expressions[] = {
+      "x+2*x-x/3",         "sin(x)*cos(x)+tan(x)", "atan(x)-asin(x/10)+acos(x/10)",
+      "sqrt(x*x+1)",       "ln(x*x+1)+log(x*x+2)", "x^2.5+(x+1)^3",
+      "x mod 0.7",         "-x*-(x+1)",            "(sin(x))*(sin(x))+cot(x+0.5)",
+  };
+  s21::SmartCalcModel calc;
+  for (const char* str : expressions) {
+    s21::CompiledExpression plain = calc.compile(str);
+    s21::CompiledExpression jitted = calc.compile(str, {.jit = true});
+    EXPECT_EQ(jitted.jitted(), s21::JitProgram::available());
+    for (double x = 0.05; x < 9; x += 0.37) {
+      double expected = plain.evaluate(x);
+      double actual = jitted.evaluate(x);
+      EXPECT_EQ(std::memcmp(&expected, &actual, sizeof(double)), 0) << str << " x=" << x;
+    }
+  }
+}
+
+TEST(JitTests, Test1) {
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression jitted = calc.compile("sqrt(x)/(x-2)+ln(x)", {.jit = true});
+  s21::CompiledExpression plain = calc.compile("sqrt(x)/(x-2)+ln(x)");
+  // Ошибки области определения приходят из интерпретатора с тем же текстом
+  EXPECT_THROW(jitted.evaluate(-1), std::invalid_argument);
+  EXPECT_THROW(jitted.evaluate(2), std::invalid_argument);
+  EXPECT_THROW(jitted.evaluate(0), std::invalid_argument);
+  EXPECT_THROW(calc.compile("asin(x)", {.jit = true}).evaluate(1.5), std::invalid_argument);
+  EXPECT_THROW(calc.compile("x mod (x-1)", {.jit = true}).evaluate(1), std::invalid_argument);
+  EXPECT_DOUBLE_EQ(jitted.evaluate(4), plain.evaluate(4));
+}
+
+TEST(JitTests, Test2) {
+  s21::SmartCalcModel calc;
+  const std::string str = "sqrt(x)*asin(x/4)+1/(x-1)+log(x+3)+x mod (x-2)";
+  s21::CompiledExpression plain = calc.compile(str);
+  s21::CompiledExpression jitted = calc.compile(str, {.jit = true});
+  // 1003 точки: полные векторы по 4 и хвост в каждом блоке
+  std::vector<double> xs(1003), expected(xs.size()), actual(xs.size());
+  std::vector<std::uint8_t> expected_valid(xs.size()), actual_valid(xs.size());
+  for (std::size_t i = 0; i < xs.size(); ++i) xs[i] = -5 + i * 0.01;
+  xs[100] = 1;
+  xs[101] = 2;
+  plain.evaluate(xs, expected, expected_valid);
+  jitted.evaluate(xs, actual, actual_valid);
+  EXPECT_EQ(expected_valid, actual_valid);
+  for (std::size_t i = 0; i < xs.size(); ++i) {
+    if (!expected_valid[i]) continue;
+    EXPECT_EQ(std::memcmp(&expected[i], &actual[i], sizeof(double)), 0) << "x=" << xs[i];
+  }
+}
+
+TEST(JitTests, Test3) {
+  // Вычисление на месте (результаты поверх x): вид ошибки точки определяется
+  // по исходному x, а не по уже записанному результату
+  s21::SmartCalcModel calc;
+  const std::string str = "1/(x-1) + sqrt(x) + ln(x-0.5)";
+  s21::CompiledExpression plain = calc.compile(str);
+  s21::CompiledExpression jitted = calc.compile(str, {.jit = true});
+  std::vector<double> xs(300);
+  for (std::size_t i = 0; i < xs.size(); ++i) xs[i] = -1 + i * 0.01;
+  xs[200] = 1;
+  std::vector<double> expected(xs.size()), in_place = xs;
+  std::vector<s21::ErrorKind> expected_errors(xs.size()), errors(xs.size());
+  plain.tryEvaluate(xs, expected, expected_errors);
+  jitted.tryEvaluate(in_place, in_place, errors);
+  EXPECT_EQ(errors, expected_errors);
+  EXPECT_EQ(errors[200], s21::ErrorKind::DIVISION_BY_ZERO);
+  EXPECT_EQ(errors[0], s21::ErrorKind::SQRT_DOMAIN);
+  for (std::size_t i = 0; i < xs.size(); ++i) {
+    if (expected_errors[i] == s21::ErrorKind::NONE) {
+      EXPECT_EQ(in_place[i], expected[i]) << xs[i];
+    }
+  }
+}
+
+TEST(JitTests, Test4) {
+  // Векторный код считает и хвосты блоков, поэтому результат точки не зависит
+  // от ее места в массиве и от размера отрезков evaluateParallel
+  s21::SmartCalcModel calc;
+  const std::string str = "sin(x)*ln(x+2)+cos(3*x)+x^1.5";
+  s21::CompiledExpression plain = calc.compile(str);
+  s21::CompiledExpression jitted = calc.compile(str, {.jit = true});
+  std::vector<double> xs(100003), expected(xs.size());
+  for (std::size_t i = 0; i < xs.size(); ++i) xs[i] = 0.001 + i * 1e-4;
+  plain.evaluate(xs, expected);
+  for (std::size_t chunk : {1, 3, 7, 4096}) {
+    std::vector<double> ys(xs.size());
+    jitted.evaluateParallel(xs, ys, {}, chunk);
+    EXPECT_EQ(std::memcmp(ys.data(), expected.data(), ys.size() * sizeof(double)), 0) << chunk;
+  }
+  // Одна и та же строка привязок в блоках из 1, 2, 3 и 5 точек
+  s21::CompiledExpression two =
+      calc.compile("a*sin(t)-ln(t)*a+t^a", {.jit = true, .variables = {"a", "t"}});
+  const std::vector<double> row = {1.25, 0.7};
+  std::vector<double> reference(1);
+  two.evaluate(row, reference);
+  for (std::size_t count : {1, 2, 3, 5}) {
+    std::vector<double> rows, ys(count);
+    for (std::size_t i = 0; i < count; ++i) rows.insert(rows.end(), row.begin(), row.end());
+    two.evaluate(rows, ys);
+    for (double y : ys) EXPECT_EQ(std::memcmp(&y, reference.data(), sizeof(double)), 0) << count;
+  }
+}
+
+TEST(AllocationTests, Test0) {
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression expr = calc.compile("(sin(x))*(sin(x))+sqrt(x*x+1)/(x+2)-x^3 mod 7");
+  std::vector<double> xs(1000), ys(xs.size());
+  std::vector<std::uint8_t> valid(xs.size());
+  for (std::size_t i = 0; i < xs.size(); ++i) xs[i] = i * 0.01;
+  expr.evaluate(xs, ys, valid);  // Прогрев буфера потока
+  std::size_t before = allocated_bytes.load();
+  double sum = 0;
+  for (double x : xs) sum += expr.evaluate(x);
+  expr.evaluate(xs, ys, valid);
+  EXPECT_EQ(allocated_bytes.load() - before, 0u);
+  EXPECT_TRUE(std::isfinite(sum));
+}
+
+TEST(AllocationTests, Test1) {
+  // Глубина стека больше kInlineStackSize: используется буфер потока
+  std::string str = "x";
+  for (int i = 0; i < 100; ++i) str = "x+(" + str + ")";
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression expr = calc.compile(str);
+  EXPECT_DOUBLE_EQ(expr.evaluate(2), 202);
+  std::size_t before = allocated_bytes.load();
+  for (int i = 0; i < 100; ++i) EXPECT_DOUBLE_EQ(expr.evaluate(i), 101.0 * i);
+  EXPECT_EQ(allocated_bytes.load() - before, 0u);
+  // Пакетная производная тоже берет стек из буфера потока
+  std::vector<double> xs(50, 1.0), values(xs.size()), derivatives(xs.size());
+  expr.evaluateDerivative(xs, values, derivatives);
+  before = allocated_bytes.load();
+  expr.evaluateDerivative(xs, values, derivatives);
+  EXPECT_EQ(allocated_bytes.load() - before, 0u);
+  EXPECT_DOUBLE_EQ(derivatives[0], 101);
+  EXPECT_DOUBLE_EQ(expr.evaluateDerivative(1.0).derivative, 101);
+}
+
+TEST(AllocationTests, Test2) {
+  // Баланс стека проверяется при компиляции
+  s21::SmartCalcModel calc;
+  EXPECT_THROW(calc.compile("2+*3"), std::invalid_argument);
+  EXPECT_THROW(calc.compile("x 2"), std::invalid_argument);
+  EXPECT_NO_THROW(calc.compile("sin(x)*cos(x)"));
+}
+
+TEST(ErrorTests, Test0) {
+  s21::SmartCalcModel calc;
+  static_assert(noexcept(std::declval<const s21::CompiledExpression&>().tryEvaluate(1.0)));
+  struct Case {
+    const char* str;
+    double x;
+    s21::ErrorKind kind;
+    std::uint32_t position;
+  };
+  const Case cases[] = {
+      {"1/(x-2)", 2, s21::ErrorKind::DIVISION_BY_ZERO, 1},
+      {"x mod (x-1)", 1, s21::ErrorKind::MODULO_BY_ZERO, 2},
+      {"sqrt(x)+ln(x)", -1, s21::ErrorKind::SQRT_DOMAIN, 0},
+      {"sqrt(x)+ln(x)", 0, s21::ErrorKind::LN_DOMAIN, 8},
+      {"2*log(x)", -3, s21::ErrorKind::LOG_DOMAIN, 2},
+      {"1+asin(x)", 2, s21::ErrorKind::ASIN_DOMAIN, 2},
+      {"acos(x)", -2, s21::ErrorKind::ACOS_DOMAIN, 0},
+      {"(x-1)^0.5", 0, s21::ErrorKind::NOT_FINITE, 5},
+      {"sqrt(x-1)", 0, s21::ErrorKind::SQRT_DOMAIN, 0},
+      {"x^1000", 10, s21::ErrorKind::NOT_FINITE, 1},
+  };
+  for (const Case& c : cases) {
+    for (bool jit : {false, true}) {
+      s21::EvalResult result = calc.compile(c.str, {.jit = jit}).tryEvaluate(c.x);
+      EXPECT_FALSE(result.has_value()) << c.str;
+      EXPECT_TRUE(std::isnan(result.value())) << c.str;
+      EXPECT_EQ(result.error().kind, c.kind) << c.str;
+      EXPECT_EQ(result.error().position, c.position) << c.str;
+    }
+  }
+}
+
+TEST(ErrorTests, Test1) {
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression expr = calc.compile("sqrt(x)*sqrt(x)+1/x");
+  s21::EvalResult result = expr.tryEvaluate(4);
+  ASSERT_TRUE(result);
+  EXPECT_DOUBLE_EQ(result.value(), 4.25);
+  EXPECT_EQ(expr.tryEvaluate(-1).error().position, 0u);
+  EXPECT_EQ(expr.tryEvaluate(0).error().kind, s21::ErrorKind::DIVISION_BY_ZERO);
+  // Исключение evaluate несет тот же текст
+  try {
+    expr.evaluate(0);
+    FAIL();
+  } catch (const std::invalid_argument& e) {
+    EXPECT_STREQ(e.what(), s21::errorMessage(s21::ErrorKind::DIVISION_BY_ZERO));
+  }
+}
+
+TEST(ErrorTests, Test2) {
+  s21::SmartCalcModel calc;
+  std::vector<double> xs = {-1, 0, 1, 2, 3, 0.5, 4, 1e308, 5};
+  std::vector<double> ys(xs.size());
+  std::vector<s21::ErrorKind> errors(xs.size());
+  const s21::ErrorKind expected[] = {
+      s21::ErrorKind::SQRT_DOMAIN, s21::ErrorKind::LN_DOMAIN, s21::ErrorKind::DIVISION_BY_ZERO,
+      s21::ErrorKind::NONE,        s21::ErrorKind::NONE,      s21::ErrorKind::NONE,
+      s21::ErrorKind::NONE,        s21::ErrorKind::NOT_FINITE, s21::ErrorKind::NONE,
+  };
+  for (bool jit : {false, true}) {
+    s21::CompiledExpression expr = calc.compile("sqrt(x)+ln(x)/ln(x)+x*x", {.jit = jit});
+    EXPECT_EQ(expr.tryEvaluate(xs, ys, errors), s21::ErrorKind::NONE);
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+      EXPECT_EQ(errors[i], expected[i]) << "x=" << xs[i];
+      EXPECT_EQ(std::isnan(ys[i]), expected[i] != s21::ErrorKind::NONE) << "x=" << xs[i];
+    }
+  }
+}
+
+TEST(ErrorTests, Test3) {
+  // Пакетный tryEvaluate сообщает о несогласованных размерах кодом, а не исключением
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression expr = calc.compile("x+1");
+  std::vector<double> xs(4, 1.0), ys(3, 7.0);
+  std::vector<s21::ErrorKind> errors(2);
+  static_assert(noexcept(expr.tryEvaluate(xs, ys, errors)));
+  EXPECT_EQ(expr.tryEvaluate(xs, ys, errors), s21::ErrorKind::BATCH_SIZE);
+  EXPECT_EQ(ys, std::vector<double>(3, 7.0));
+  EXPECT_STREQ(s21::errorMessage(s21::ErrorKind::BATCH_SIZE), "Input and output sizes differ.");
+  ys.resize(4);
+  EXPECT_EQ(expr.tryEvaluate(xs, ys, errors), s21::ErrorKind::BATCH_SIZE);
+  EXPECT_EQ(expr.tryEvaluate(xs, ys, {}), s21::ErrorKind::NONE);
+  EXPECT_EQ(ys, std::vector<double>(4, 2.0));
+}
+
+TEST(ErrorTests, Test4) {
+  // Нехватка памяти для буфера стека сообщается кодом ошибки: tryEvaluate не
+  // бросает исключений и не завершает программу
+  s21::SmartCalcModel calc;
+  std::string str = "x";
+  // Вложенность справа: стек глубже встроенного буфера скалярного вычисления
+  for (int i = 0; i < 100; ++i) str = "x*" + std::to_string(i) + "+(" + str + ")";
+  s21::CompiledExpression expr = calc.compile(str);
+  std::vector<double> xs(1000, 1.0), ys(xs.size());
+  s21::ErrorKind batch = s21::ErrorKind::NONE;
+  s21::EvalResult point = 0.0;
+  // Новый поток: его буферы стека еще пусты
+  std::thread([&] {
+    fail_allocations = true;
+    batch = expr.tryEvaluate(xs, ys, {});
+    point = expr.tryEvaluate(1.0);
+    fail_allocations = false;
+  }).join();
+  EXPECT_EQ(batch, s21::ErrorKind::OUT_OF_MEMORY);
+  ASSERT_FALSE(point.has_value());
+  EXPECT_EQ(point.error().kind, s21::ErrorKind::OUT_OF_MEMORY);
+  EXPECT_STREQ(s21::errorMessage(s21::ErrorKind::OUT_OF_MEMORY), "Not enough memory for evaluation.");
+  EXPECT_EQ(expr.tryEvaluate(xs, ys, {}), s21::ErrorKind::NONE);
+  EXPECT_DOUBLE_EQ(ys[0], expr.evaluate(1.0));
+}
+
+TEST(LexerTests, Test0) {
+  s21::SmartCalcModel calc;
+  EXPECT_DOUBLE_EQ(calc.parse(".5+x", 2), 2.5);
+  EXPECT_DOUBLE_EQ(calc.parse("12.375*2", 0), 24.75);
+  EXPECT_DOUBLE_EQ(calc.parse("1 2+x", 1), 13);  // Пробелы внутри числа игнорируются
+  EXPECT_DOUBLE_EQ(calc.parse("0.1+0.2", 0), 0.1 + 0.2);
+  EXPECT_THROW(calc.compile("1.2.3+x"), std::invalid_argument);
+  EXPECT_THROW(calc.compile("x+."), std::invalid_argument);
+}
+
+TEST(LexerTests, Test1) {
+  s21::SmartCalcModel calc;
+  std::string_view view = "sqrt(x)+lnx";
+  EXPECT_DOUBLE_EQ(calc.compile(view.substr(0, 7)).evaluate(16), 4);
+  EXPECT_DOUBLE_EQ(calc.parse("asin(x)+acos(x)+atan(x)+cot(1)", 0.5),
+                   std::asin(0.5) + std::acos(0.5) + std::atan(0.5) + 1 / std::tan(1.0));
+  EXPECT_DOUBLE_EQ(calc.parse("log(x)+ln(x)+x mod 3", 10), 1 + std::log(10.0) + 1);
+  EXPECT_THROW(calc.compile("si(x)"), std::invalid_argument);
+}
+
+TEST(KeywordTests, Test0) {
+  for (const s21::Keyword& keyword : s21::kKeywords) {
+    const s21::Keyword* found = s21::kKeywordTrie.match(std::string(keyword.name) + "(x)");
+    ASSERT_NE(found, nullptr) << keyword.name;
+    EXPECT_EQ(found->type, keyword.type);
+    EXPECT_EQ(found->name, keyword.name);
+  }
+  EXPECT_EQ(s21::kKeywordTrie.match("co(x)"), nullptr);
+  EXPECT_EQ(s21::kKeywordTrie.match("as"), nullptr);
+  EXPECT_EQ(s21::kKeywordTrie.match("Sin(x)"), nullptr);
+}
+
+TEST(KeywordTests, Test1) {
+  s21::SmartCalcModel calc;
+  EXPECT_DOUBLE_EQ(calc.parse("sinx+cos x", 1), std::sin(1.0) + std::cos(1.0));
+  EXPECT_DOUBLE_EQ(calc.parse("7mod x", 4), 3);
+  EXPECT_THROW(calc.compile("co(x)"), std::invalid_argument);
+  EXPECT_THROW(calc.compile("sqr(x)"), std::invalid_argument);
+}
+
+TEST(StreamingTests, Test0) {
+  // Глубина вложенности больше встроенного буфера стека операторов
+  std::string str;
+  for (int i = 0; i < 5000; ++i) str += "(1+";
+  str += "x";
+  for (int i = 0; i < 5000; ++i) str += ")";
+  s21::SmartCalcModel calc;
+  EXPECT_DOUBLE_EQ(calc.compile(str).evaluate(2), 5002);
+  EXPECT_DOUBLE_EQ(calc.parse(std::string(1001, '-') + "x", 3), -3);
+}
+
+TEST(StreamingTests, Test1) {
+  std::string str = "x";
+  double expected = 0.5;
+  for (int i = 0; i < 20000; ++i) {
+    str += i % 2 ? "+x*2" : "-1/x";
+    expected += i % 2 ? 0.5 * 2 : -1 / 0.5;
+  }
+  s21::SmartCalcModel calc;
+  EXPECT_NEAR(calc.compile(str).evaluate(0.5), expected, 1e-9);
+}
+
+TEST(StreamingTests, Test2) {
+  s21::SmartCalcModel calc;
+  EXPECT_THROW(calc.compile("(x+1))"), std::invalid_argument);
+  EXPECT_THROW(calc.compile("((x+1)"), std::invalid_argument);
+  EXPECT_THROW(calc.compile("x+1)("), std::invalid_argument);
+  EXPECT_THROW(calc.compile("()"), std::invalid_argument);
+  EXPECT_TRUE(calc.compile("   ").empty());
+}
+
+TEST(VariableTests, Test0) {
+  s21::SmartCalcModel calc;
+  for (bool jit : {false, true}) {
+    s21::CompiledExpression compiled =
+        calc.compile("a*b+rate/a-sqrt(b)", {.jit = jit, .variables = {"a", "b", "rate"}});
+    EXPECT_EQ(compiled.variables(), 3u);
+    std::vector<double> bindings = {2, 9, 0.5};
+    EXPECT_DOUBLE_EQ(compiled.evaluate(bindings), 2 * 9 + 0.5 / 2 - 3);
+    s21::EvalResult result = compiled.tryEvaluate(std::span<const double>(bindings).first(2));
+    ASSERT_FALSE(result);
+    EXPECT_EQ(result.error().kind, s21::ErrorKind::BINDING_SIZE);
+    EXPECT_THROW(compiled.evaluate(1.0), std::invalid_argument);
+  }
+}
+
+TEST(VariableTests, Test1) {
+  // Строки привязок (a, t): пакетные пути совпадают друг с другом и близки к скалярному
+  const std::size_t count = 1001;
+  std::vector<double> rows(count * 2), batch(count), parallel(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    rows[2 * i] = i * 0.01 - 3;
+    rows[2 * i + 1] = i * 0.002;
+  }
+  s21::SmartCalcModel calc;
+  for (bool jit : {false, true}) {
+    s21::CompiledExpression compiled =
+        calc.compile("a*sin(t)+t^2-ln(t)*a", {.jit = jit, .variables = {"a", "t"}});
+    std::vector<std::uint8_t> valid(count);
+    compiled.evaluate(rows, batch, valid);
+    compiled.evaluateParallel(rows, parallel, {}, 64);
+    for (std::size_t i = 0; i < count; ++i) {
+      s21::EvalResult expected = compiled.tryEvaluate(std::span<const double>(rows).subspan(2 * i, 2));
+      EXPECT_EQ(valid[i], expected.has_value() ? 1 : 0);
+      if (expected) {
+        EXPECT_NEAR(batch[i], expected.value(), 1e-13);
+        EXPECT_EQ(parallel[i], batch[i]);
+      }
+    }
+    EXPECT_THROW(compiled.evaluate(std::span<const double>(rows).first(count), batch),
+                 std::invalid_argument);
+  }
+}
+
+TEST(VariableTests, Test2) {
+  s21::SmartCalcModel calc;
+  std::vector<double> bindings = {0.5, 2};
+  // Ключевое слово не мешает переменной, начинающейся так же, и наоборот
+  EXPECT_DOUBLE_EQ(calc.compile("cost*tan(t)", {.variables = {"t", "cost"}}).evaluate(bindings),
+                   2 * std::tan(0.5));
+  EXPECT_DOUBLE_EQ(calc.compile("m-1", {.variables = {"m"}}).evaluate(3.0), 2);
+  EXPECT_DOUBLE_EQ(calc.compile("t mod -3", {.variables = {"t"}}).evaluate(7.0), 1);
+  EXPECT_THROW(calc.compile("y+1", {.variables = {"t"}}), std::invalid_argument);
+  EXPECT_THROW(calc.compile("x+1", {.variables = {"t"}}), std::invalid_argument);
+  EXPECT_THROW(calc.compile("t", {.variables = {"sin"}}), std::invalid_argument);
+  EXPECT_THROW(calc.compile("t", {.variables = {"t", "t"}}), std::invalid_argument);
+  EXPECT_THROW(calc.compile("t", {.variables = {"1t"}}), std::invalid_argument);
+}
+
+TEST(ConcurrencyTests, Test0) {
+  // Одно выражение вычисляется из многих потоков без синхронизации
+  const s21::SmartCalcModel calc;
+  for (bool jit : {false, true}) {
+    const s21::CompiledExpression compiled =
+        calc.compile("sin(x)*x^2+sqrt(x+1)/(x+2)-ln(x)", {.jit = jit});
+    std::vector<double> xs(4096), expected(xs.size());
+    for (std::size_t i = 0; i < xs.size(); ++i) xs[i] = i * 0.01 - 1;
+    compiled.evaluate(xs, expected);
+    std::vector<std::thread> threads;
+    std::atomic<int> failures{0};
+    for (int t = 0; t < 16; ++t) {
+      threads.emplace_back([&compiled, &xs, &expected, &failures, t] {
+        std::vector<double> ys(xs.size());
+        for (int round = 0; round < 4; ++round) {
+          if ((t + round) % 2) compiled.evaluate(xs, ys);
+          else compiled.evaluateParallel(xs, ys, {}, 256);
+          for (std::size_t i = t; i < xs.size(); i += 16) {
+            s21::EvalResult result = compiled.tryEvaluate(xs[i]);
+            if (result ? std::fabs(result.value() - expected[i]) > 1e-12 : !std::isnan(expected[i])) ++failures;
+          }
+          if (std::memcmp(ys.data(), expected.data(), ys.size() * sizeof(double)) != 0) ++failures;
+        }
+      });
+    }
+    for (std::thread& thread : threads) thread.join();
+    EXPECT_EQ(failures, 0);
+  }
+}
+
+TEST(ConcurrencyTests, Test1) {
+  // Одна модель компилирует выражения одновременно в нескольких потоках
+  const auto calc = std::make_shared<const s21::SmartCalcModel>();
+  std::vector<std::thread> threads;
+  std::atomic<int> failures{0};
+  for (int t = 0; t < 12; ++t) {
+    threads.emplace_back([calc, &failures, t] {
+      for (int i = 0; i < 200; ++i) {
+        std::string str = "x*" + std::to_string(i) + "+" + std::to_string(t);
+        s21::CompiledExpression compiled = calc->compile(str, {.jit = i % 2 == 0});
+        if (compiled.evaluate(3) != 3.0 * i + t) ++failures;
+        if (calc->parse(str, 1) != 1.0 * i + t) ++failures;
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_EQ(failures, 0);
+}
+
+TEST(ConcurrencyTests, Test2) {
+  // Общий const контроллер: кэш, пакетное и параллельное вычисление вперемешку
+  const s21::SmartCalcController controller(4);
+  const s21::CompiledExpression compiled = controller.compileExpression("x^2-1");
+  std::vector<std::thread> threads;
+  std::atomic<int> failures{0};
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&controller, &compiled, &failures, t] {
+      std::vector<double> xs(3000, t), ys(xs.size());
+      for (int i = 0; i < 50; ++i) {
+        if (controller.calculateExpression("x+" + std::to_string(i % 6), t) != t + i % 6) ++failures;
+        if (i % 2) controller.calculateBatch(compiled, xs, ys);
+        else controller.calculateBatchParallel(compiled, xs, ys, {}, 500);
+        if (ys.back() != t * t - 1.0) ++failures;
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_EQ(failures, 0);
+  EXPECT_LE(controller.cacheStats().size, 4u);
+}
+
+TEST(IntervalTests, Test0) {
+  // Значение в любой точке отрезка лежит в интервальной оценке
+  const char* expressions[] = {"x^2-3*x+1", "sin(x)*cos(x)", "tan(x)/2", "cot(x)", "x mod 1.5",
+                               "2^x+x^3", "x^0.5", "sqrt(x)+ln(x)", "asin(x)-acos(x)+atan(x)",
+                               "(x-1)/(x+1)", "log(x)*x^-2"};
+  const s21::Interval ranges[] = {{-2, 3}, {0.1, 0.4}, {-1, 1}, {1, 5.5}, {-7.25, -0.5}};
+  s21::SmartCalcModel calc;
+  for (const char* str : expressions) {
+    s21::CompiledExpression compiled = calc.compile(str);
+    for (const s21::Interval& range : ranges) {
+      s21::IntervalResult result = compiled.evaluateInterval(range);
+      for (int i = 0; i <= 1000; ++i) {
+        s21::EvalResult point = compiled.tryEvaluate(range.lo + range.width() * i / 1000);
+        if (!point) continue;
+        EXPECT_TRUE(result.defined) << str;
+        EXPECT_TRUE(result.range.contains(point.value())) << str << " at " << range.lo;
+      }
+    }
+  }
+}
+
+TEST(IntervalTests, Test1) {
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression root = calc.compile("sqrt(x)");
+  EXPECT_FALSE(root.evaluateInterval({-2, -1}).defined);
+  s21::IntervalResult partial = root.evaluateInterval({-1, 4});
+  EXPECT_TRUE(partial.defined);
+  EXPECT_FALSE(partial.total);
+  EXPECT_LE(partial.range.lo, 0);
+  EXPECT_GE(partial.range.hi, 2);
+  EXPECT_TRUE(calc.compile("ln(x)").evaluateInterval({1, 2}).total);
+  EXPECT_FALSE(calc.compile("ln(x)").evaluateInterval({0, 2}).total);
+  s21::IntervalResult pole = calc.compile("1/x").evaluateInterval({-1, 1});
+  EXPECT_FALSE(pole.total);
+  EXPECT_TRUE(std::isinf(pole.range.lo) && std::isinf(pole.range.hi));
+  EXPECT_FALSE(calc.compile("1/(x-x)").evaluateInterval({0, 1}).defined);
+  EXPECT_FALSE(calc.compile("tan(x)").evaluateInterval({1, 2}).total);
+  EXPECT_TRUE(calc.compile("tan(x)").evaluateInterval({-1, 1}).total);
+}
+
+TEST(IntervalTests, Test2) {
+  s21::SmartCalcModel calc;
+  // Оценки узкие: sin на полном периоде, квадрат без ложной отрицательной части
+  s21::IntervalResult wave = calc.compile("sin(x)").evaluateInterval({0, 7});
+  EXPECT_DOUBLE_EQ(wave.range.lo, -1);
+  EXPECT_DOUBLE_EQ(wave.range.hi, 1);
+  s21::IntervalResult parabola = calc.compile("x^2").evaluateInterval({-2, 3});
+  EXPECT_EQ(parabola.range.lo, 0);
+  EXPECT_NEAR(parabola.range.hi, 9, 1e-12);
+  s21::IntervalResult flat = calc.compile("x mod 2").evaluateInterval({4.25, 4.5});
+  EXPECT_NEAR(flat.range.lo, 0.25, 1e-12);
+  EXPECT_NEAR(flat.range.hi, 0.5, 1e-12);
+  std::vector<s21::Interval> bindings = {{1, 2}, {-1, 0}};
+  s21::IntervalResult sum =
+      calc.compile("a+b", {.variables = {"a", "b"}}).evaluateInterval(bindings);
+  EXPECT_TRUE(sum.total);
+  EXPECT_NEAR(sum.range.lo, 0, 1e-12);
+  EXPECT_NEAR(sum.range.hi, 2, 1e-12);
+  EXPECT_THROW(calc.compile("a+b", {.variables = {"a", "b"}}).evaluateInterval({0, 1}),
+               std::invalid_argument);
+}
+
+TEST(IntervalTests, Test3) {
+  // Большой целый показатель при отрицательном основании: оценка содержит
+  // значения в точках, как и при малом показателе
+  s21::SmartCalcModel calc;
+  for (const char* str : {"(x-1)^2000000000", "(x-1)^2000000001", "(x-1)^(2^60)", "(x-3)^3000000000"}) {
+    s21::CompiledExpression compiled = calc.compile(str);
+    const s21::Interval range = {0.25, 0.75};
+    s21::IntervalResult result = compiled.evaluateInterval(range);
+    EXPECT_TRUE(result.defined) << str;
+    for (double x : {0.25, 0.5, 0.75}) {
+      s21::EvalResult point = compiled.tryEvaluate(x);
+      if (point) {
+        EXPECT_TRUE(result.range.contains(point.value())) << str << " at " << x;
+      }
+    }
+  }
+  s21::IntervalResult even = calc.compile("(x-3)^3000000000").evaluateInterval({1.5, 2.5});
+  EXPECT_NEAR(even.range.lo, 0, 1e-300);
+  EXPECT_TRUE(std::isinf(even.range.hi));
+}
+
+TEST(DualTests, Test0) {
+  // Производная совпадает с аналитической для всех функций
+  struct Case {
+    const char* str;
+    double (*derivative)(double);
+  };
+  const Case cases[] = {
+      {"sin(x)*x^2", [](double x) { return std::cos(x) * x * x + 2 * x * std::sin(x); }},
+      {"cos(x)/x", [](double x) { return (-std::sin(x) * x - std::cos(x)) / (x * x); }},
+      {"tan(x)-cot(x)", [](double x) { return 1 / std::pow(std::cos(x), 2) + 1 / std::pow(std::sin(x), 2); }},
+      {"asin(x)+acos(x/2)", [](double x) { return 1 / std::sqrt(1 - x * x) - 0.5 / std::sqrt(1 - x * x / 4); }},
+      {"atan(x)*sqrt(x)", [](double x) { return std::sqrt(x) / (1 + x * x) + std::atan(x) / (2 * std::sqrt(x)); }},
+      {"log(x)-ln(x^3)", [](double x) { return 1 / (x * std::log(10)) - 3 / x; }},
+      {"x^x", [](double x) { return std::pow(x, x) * (std::log(x) + 1); }},
+      {"-(2^x) mod 7", [](double x) { return -std::log(2) * std::pow(2, x); }},
+  };
+  s21::SmartCalcModel calc;
+  for (bool jit : {false, true}) {
+    for (const Case& c : cases) {
+      s21::CompiledExpression compiled = calc.compile(c.str, {.jit = jit});
+      for (double x : {0.3, 0.5, 0.9}) {
+        s21::Dual dual = compiled.evaluateDerivative(x);
+        EXPECT_EQ(dual.value, compiled.evaluate(x)) << c.str;
+        EXPECT_NEAR(dual.derivative, c.derivative(x), 1e-12 * std::max(1.0, std::abs(dual.derivative)))
+            << c.str << " at " << x;
+      }
+    }
+  }
+}
+
+TEST(DualTests, Test1) {
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression compiled = calc.compile("sqrt(x)*ln(x+2)");
+  std::vector<double> xs(500), values(xs.size()), derivatives(xs.size());
+  std::vector<std::uint8_t> valid(xs.size());
+  for (std::size_t i = 0; i < xs.size(); ++i) xs[i] = i * 0.01 - 1;
+  compiled.evaluateDerivative(xs, values, derivatives, valid);
+  for (std::size_t i = 0; i < xs.size(); ++i) {
+    s21::EvalResult expected = compiled.tryEvaluate(xs[i]);
+    ASSERT_EQ(valid[i], expected ? 1 : 0);
+    if (!expected) {
+      EXPECT_TRUE(std::isnan(values[i]) && std::isnan(derivatives[i]));
+      continue;
+    }
+    s21::Dual dual = compiled.evaluateDerivative(xs[i]);
+    EXPECT_EQ(values[i], expected.value());
+    EXPECT_EQ(derivatives[i], dual.derivative);
+  }
+  EXPECT_THROW(compiled.evaluateDerivative(-1.0), std::invalid_argument);
+  EXPECT_THROW(compiled.evaluateDerivative(xs, values, std::span<double>(derivatives).first(3)),
+               std::invalid_argument);
+}
+
+TEST(DualTests, Test2) {
+  // Частные производные по каждой переменной
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression compiled = calc.compile("a*b^2+sin(a*b)", {.variables = {"a", "b"}});
+  std::vector<double> bindings = {1.5, -0.5};
+  double a = 1.5, b = -0.5;
+  EXPECT_NEAR(compiled.evaluateDerivative(bindings, 0).derivative, b * b + b * std::cos(a * b), 1e-14);
+  EXPECT_NEAR(compiled.evaluateDerivative(bindings, 1).derivative, 2 * a * b + a * std::cos(a * b), 1e-14);
+  EXPECT_EQ(calc.compile("7").evaluateDerivative(3.0).derivative, 0);
+  EXPECT_EQ(calc.compile("x").evaluateDerivative(3.0).derivative, 1);
+}
+
+TEST(DualTests, Test3) {
+  // Производная без исключений: ошибка с позицией токена, как у tryEvaluate
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression compiled = calc.compile("x*x+sqrt(x)");
+  s21::Dual result{};
+  static_assert(noexcept(compiled.tryEvaluateDerivative(1.0, result)));
+  EXPECT_EQ(compiled.tryEvaluateDerivative(4.0, result).kind, s21::ErrorKind::NONE);
+  s21::Dual expected = compiled.evaluateDerivative(4.0);
+  EXPECT_EQ(result.value, expected.value);
+  EXPECT_EQ(result.derivative, expected.derivative);
+  s21::EvalError error = compiled.tryEvaluateDerivative(-1.0, result);
+  EXPECT_EQ(error.kind, s21::ErrorKind::SQRT_DOMAIN);
+  EXPECT_EQ(error.position, compiled.tryEvaluate(-1.0).error().position);
+  EXPECT_TRUE(std::isnan(result.value) && std::isnan(result.derivative));
+  s21::CompiledExpression two = calc.compile("a*b", {.variables = {"a", "b"}});
+  std::vector<double> bindings = {2};
+  EXPECT_EQ(two.tryEvaluateDerivative(bindings, 0, result).kind, s21::ErrorKind::BINDING_SIZE);
+}
+
+TEST(DerivativeTests, Test0) {
+  // Символьная производная совпадает с автоматической
+  const char* expressions[] = {"sin(x)*x^2", "cos(x)/x", "tan(x)-cot(x)", "asin(x)+acos(x/2)",
+                               "atan(x)*sqrt(x)", "log(x)-ln(x^3)", "x^x", "-(2^x) mod 7",
+                               "x^2.5/(1+x)", "(x mod 0.2)*x"};
+  s21::SmartCalcModel calc;
+  for (const char* str : expressions) {
+    s21::CompiledExpression compiled = calc.compile(str);
+    s21::CompiledExpression derivative = calc.derivative(compiled);
+    for (double x : {0.3, 0.5, 0.9}) {
+      double expected = compiled.evaluateDerivative(x).derivative;
+      EXPECT_NEAR(derivative.evaluate(x), expected, 1e-12 * std::max(1.0, std::abs(expected)))
+          << str << " at " << x;
+    }
+  }
+}
+
+TEST(DerivativeTests, Test1) {
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression wave = calc.compile("sin(x)");
+  EXPECT_DOUBLE_EQ(calc.derivative(wave, 2).evaluate(0.7), -std::sin(0.7));
+  EXPECT_DOUBLE_EQ(calc.derivative(wave, 4).evaluate(0.7), std::sin(0.7));
+  s21::CompiledExpression quartic = calc.compile("x^4-3*x^2+x");
+  EXPECT_DOUBLE_EQ(calc.derivative(quartic, 3).evaluate(2), 48);
+  s21::CompiledExpression constant = calc.derivative(quartic, 5);
+  EXPECT_EQ(constant.size(), 1u);
+  EXPECT_EQ(constant.evaluate(2), 0);
+  // Упрощение: (3x)' = 3, а не 0*x+3*1
+  EXPECT_EQ(calc.derivative(calc.compile("3*x+1")).size(), 1u);
+  EXPECT_EQ(calc.derivative(wave, 0).size(), wave.size());
+}
+
+TEST(DerivativeTests, Test2) {
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression compiled =
+      calc.compile("a*b^2+sin(a*b)", {.jit = true, .variables = {"a", "b"}});
+  s21::CompiledExpression by_b = calc.derivative(compiled, 1, 1);
+  EXPECT_EQ(by_b.jitted(), compiled.jitted());
+  std::vector<double> bindings = {1.5, -0.5};
+  EXPECT_NEAR(by_b.evaluate(bindings), 2 * 1.5 * -0.5 + 1.5 * std::cos(1.5 * -0.5), 1e-14);
+  EXPECT_THROW(calc.derivative(compiled, 1, 2), std::invalid_argument);
+  // Пакетное вычисление производной совпадает со скалярным с точностью до
+  // ulp векторного ln
+  s21::CompiledExpression derivative = calc.derivative(calc.compile("sqrt(x)*ln(x+2)"));
+  std::vector<double> xs(10000), ys(xs.size());
+  for (std::size_t i = 0; i < xs.size(); ++i) xs[i] = 0.01 + i * 1e-3;
+  derivative.evaluate(xs, ys);
+  for (std::size_t i = 0; i < xs.size(); i += 97) {
+    const double expected = derivative.evaluate(xs[i]);
+    EXPECT_NEAR(ys[i], expected, 1e-14 * std::fabs(expected));
+  }
+}
+
+TEST(SolverTests, Test0) {
+  s21::SmartCalcModel calc;
+  s21::RootSolver solver;
+  s21::SolveResult result = solver.solve(calc.compile("sin(x)"), -10, 10);
+  ASSERT_EQ(result.roots.size(), 7u);
+  for (std::size_t k = 0; k < 7; ++k) {
+    EXPECT_NEAR(result.roots[k].x, (static_cast<int>(k) - 3) * M_PI, 1e-12);
+    EXPECT_TRUE(result.roots[k].converged);
+  }
+  EXPECT_EQ(result.stats.brackets, 6u);  // Корень 0 - узел сетки
+  EXPECT_GT(result.stats.newton_steps, 0u);
+  EXPECT_EQ(result.stats.evaluations, 4097 + result.stats.iterations);
+}
+
+TEST(SolverTests, Test1) {
+  s21::SmartCalcModel calc;
+  s21::RootSolver solver;
+  // Смена знака на полюсе - не корень
+  s21::SolveResult pole = solver.solve(calc.compile("1/(x-0.3)"), -1, 1.1);
+  EXPECT_TRUE(pole.roots.empty());
+  EXPECT_EQ(pole.stats.rejected, 1u);
+  s21::SolveResult square = solver.solve(calc.compile("x^2-2"), -3, 3);
+  ASSERT_EQ(square.roots.size(), 2u);
+  EXPECT_NEAR(square.roots[0].x, -std::sqrt(2.0), 1e-12);
+  EXPECT_NEAR(square.roots[1].x, std::sqrt(2.0), 1e-12);
+  // Точки вне области определения пропускаются
+  s21::SolveResult domain = solver.solve(calc.compile("sqrt(x)-1"), -5, 5);
+  ASSERT_EQ(domain.roots.size(), 1u);
+  EXPECT_NEAR(domain.roots[0].x, 1, 1e-12);
+}
+
+TEST(SolverTests, Test2) {
+  // Результат и статистика не зависят от числа потоков
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression cubic = calc.compile("(x-1)*(x-2)*(x-3)*sin(5*x)");
+  s21::ThreadPool single(1), many(4);
+  s21::SolveResult a = s21::RootSolver({.samples = 1000}, single).solve(cubic, 0.1, 3.5);
+  s21::SolveResult b = s21::RootSolver({.samples = 1000}, many).solve(cubic, 0.1, 3.5);
+  ASSERT_EQ(a.roots.size(), b.roots.size());
+  EXPECT_EQ(a.roots.size(), 8u);
+  for (std::size_t i = 0; i < a.roots.size(); ++i) EXPECT_EQ(a.roots[i].x, b.roots[i].x);
+  EXPECT_EQ(a.stats.evaluations, b.stats.evaluations);
+  EXPECT_EQ(a.stats.iterations, b.stats.iterations);
+  s21::RootSolver solver;
+  EXPECT_THROW(solver.solve(cubic, 2, 1), std::invalid_argument);
+  EXPECT_THROW(solver.solve(calc.compile("a", {.variables = {"a", "b"}}), 0, 1), std::invalid_argument);
+}
+
+TEST(IntegrationTests, Test0) {
+  // Гладкие функции: точность до допуска за одну-две итерации
+  s21::SmartCalcModel calc;
+  s21::Integrator integrator;
+  s21::IntegrationResult r = integrator.integrate(calc.compile("sin(x)"), 0, M_PI);
+  EXPECT_TRUE(r.converged);
+  EXPECT_NEAR(r.value, 2.0, 1e-12);
+  EXPECT_LE(r.error, 1e-10);
+  EXPECT_EQ(r.evaluations % 21, 0u);
+  r = integrator.integrate(calc.compile("x^2"), 3, 0);
+  EXPECT_NEAR(r.value, -9.0, 1e-12);
+  r = integrator.integrate(calc.compile("ln(x)"), 0, 1);
+  EXPECT_NEAR(r.value, -1.0, 1e-8);
+  EXPECT_EQ(integrator.integrate(calc.compile("x"), 2, 2).value, 0.0);
+}
+
+TEST(IntegrationTests, Test1) {
+  // Бюджет вычислений ограничивает работу и снимает признак сходимости
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression spiky = calc.compile("sqrt(x*x)^0.5");
+  s21::IntegrationResult full = s21::Integrator().integrate(spiky, -1, 1);
+  EXPECT_TRUE(full.converged);
+  EXPECT_NEAR(full.value, 4.0 / 3, 1e-9);
+  s21::IntegrationResult cut = s21::Integrator({.max_evaluations = 200}).integrate(spiky, -1, 1);
+  EXPECT_FALSE(cut.converged);
+  EXPECT_LE(cut.evaluations, 200u);
+  EXPECT_GT(cut.error, 0.0);
+  EXPECT_NEAR(cut.value, 4.0 / 3, 1e-3);
+  EXPECT_THROW(s21::Integrator().integrate(calc.compile("1/x"), -1, 1), std::invalid_argument);
+  EXPECT_THROW(s21::Integrator().integrate(spiky, 0, INFINITY), std::invalid_argument);
+}
+
+TEST(IntegrationTests, Test2) {
+  // Результат не зависит от числа потоков; доступ через контроллер
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression wave = calc.compile("sin(50*x)/(x+1)+sqrt(x)");
+  s21::CompiledExpression square = calc.compile("x^2");
+  s21::ThreadPool single(1);
+  s21::IntegrationResult a = s21::Integrator({}, single).integrate(wave, 0, 10);
+  s21::IntegrationResult a_square = s21::Integrator({}, single).integrate(square, 0, 3);
+  for (std::size_t threads : {3u, 5u}) {
+    s21::ThreadPool pool(threads);
+    s21::IntegrationResult b = s21::Integrator({}, pool).integrate(wave, 0, 10);
+    EXPECT_EQ(a.value, b.value) << threads;
+    EXPECT_EQ(a.error, b.error) << threads;
+    EXPECT_EQ(a.intervals, b.intervals) << threads;
+    EXPECT_EQ(a.evaluations, b.evaluations) << threads;
+    EXPECT_EQ(a_square.value, s21::Integrator({}, pool).integrate(square, 0, 3).value) << threads;
+  }
+  s21::SmartCalcController controller;
+  s21::IntegrationResult c = controller.calculateIntegral("x^3 - 2*x", -1, 2, {.max_evaluations = 10000});
+  EXPECT_TRUE(c.converged);
+  EXPECT_NEAR(c.value, 0.75, 1e-12);
+  EXPECT_LE(c.evaluations, 10000u);
+}
+
+TEST(FloatTests, Test0) {
+  // Вычисление в float: тот же результат, что у выражения, посчитанного в float
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression single = calc.compile("sin(x)*x+1/(x+2)", {.precision = s21::Precision::FLOAT});
+  EXPECT_EQ(single.precision(), s21::Precision::FLOAT);
+  EXPECT_EQ(calc.compile("x").precision(), s21::Precision::DOUBLE);
+  for (float x : {0.1f, 1.5f, -0.75f, 30.0f}) {
+    float expected = std::sin(x) * x + 1.0f / (x + 2.0f);
+    EXPECT_EQ(single.evaluate(x), static_cast<double>(expected));
+    EXPECT_NEAR(single.evaluate(x), std::sin(double(x)) * x + 1 / (double(x) + 2), 1e-5);
+  }
+  s21::EvalResult error = single.tryEvaluate(-2.0);
+  EXPECT_EQ(error.error().kind, s21::ErrorKind::DIVISION_BY_ZERO);
+  EXPECT_EQ(error.error().position, 10u);
+  // Машинный код генерируется только для double
+  EXPECT_FALSE(calc.compile("x+1", {.jit = true, .precision = s21::Precision::FLOAT}).jitted());
+}
+
+TEST(FloatTests, Test1) {
+  // Пакетное вычисление над массивами float совпадает со скалярным побитово
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression single =
+      calc.compile("sqrt(x)*x - ln(x) + 2*x/(x-3)", {.precision = s21::Precision::FLOAT});
+  std::vector<float> xs(1000), ys(xs.size());
+  std::vector<std::uint8_t> valid(xs.size());
+  for (std::size_t i = 0; i < xs.size(); ++i) xs[i] = static_cast<float>(i) * 0.01f - 2.0f;
+  single.evaluate(xs, ys, valid);
+  std::vector<float> parallel(xs.size());
+  single.evaluateParallel(xs, parallel, {}, 64);
+  for (std::size_t i = 0; i < xs.size(); ++i) {
+    s21::EvalResult expected = single.tryEvaluate(xs[i]);
+    ASSERT_EQ(valid[i] != 0, expected.has_value()) << xs[i];
+    if (!valid[i]) {
+      EXPECT_TRUE(std::isnan(ys[i]));
+      continue;
+    }
+    EXPECT_EQ(ys[i], static_cast<float>(expected.value()));
+    EXPECT_EQ(parallel[i], ys[i]);
+  }
+  EXPECT_EQ(valid[0], 0);
+  EXPECT_EQ(valid[200], 0);
+  EXPECT_EQ(valid[500], 0);
+  EXPECT_THROW(single.evaluate(xs, std::span<float>(ys.data(), 10)), std::invalid_argument);
+}
+
+TEST(FloatTests, Test2) {
+  // Смешанные типы массивов и несколько переменных
+  s21::SmartCalcModel calc;
+  s21::CompiledExpression single =
+      calc.compile("a*b - cos(a)", {.variables = {"a", "b"}, .precision = s21::Precision::FLOAT});
+  s21::CompiledExpression twice = calc.compile("a*b - cos(a)", {.variables = {"a", "b"}});
+  std::vector<double> rows = {1, 2, 0.5, -4, 3, 0.25};
+  std::vector<double> results(3);
+  single.evaluate(rows, results);
+  for (std::size_t i = 0; i < 3; ++i) {
+    EXPECT_EQ(results[i], single.evaluate(std::span<const double>(rows.data() + 2 * i, 2)));
+    EXPECT_NEAR(results[i], twice.evaluate(std::span<const double>(rows.data() + 2 * i, 2)), 1e-6);
+  }
+  // Выражение double на массивах float считается в double
+  std::vector<float> rows_float(rows.begin(), rows.end()), results_float(3);
+  twice.evaluate(rows_float, results_float);
+  for (std::size_t i = 0; i < 3; ++i) {
+    EXPECT_EQ(results_float[i], static_cast<float>(twice.evaluate(std::span<const double>(rows.data() + 2 * i, 2))));
+  }
+  // Производная сохраняет точность исходного выражения
+  EXPECT_EQ(calc.derivative(single).precision(), s21::Precision::FLOAT);
+}
+
+TEST(CtExprTests, Test0) {
+  // Выражения, разобранные при компиляции, дают те же значения, что и модель
+  s21::SmartCalcModel calc;
+  using Square = s21::ct_expr<"sin(x)^2+1">;
+  using Mixed = s21::ct_expr<"-x mod 3 + 2^-x*cos(x)/ sqrt(x*x+1) - ln(2.5) + atan(.5) + 1 2.5">;
+  static_assert(Square::kVariableCount == 1);
+  static_assert(Square::size() == 6);
+  for (double x : {-2.5, -0.3, 0.0, 0.7, 4.0}) {
+    EXPECT_EQ(Square::evaluate(x), calc.parse("sin(x)^2+1", x));
+    EXPECT_EQ(Mixed{}(x), calc.parse("-x mod 3 + 2^-x*cos(x)/ sqrt(x*x+1) - ln(2.5) + atan(.5) + 1 2.5", x));
+  }
+  // Ежемесячный платеж по аннуитету: переменные перечисляются после выражения
+  using Annuity = s21::ct_expr<"P*r/(1-(1+r)^(-n))", "P", "r", "n">;
+  static_assert(Annuity::kVariableCount == 3);
+  const double r = 0.12 / 12;
+  EXPECT_DOUBLE_EQ(Annuity::evaluate(100000, r, 12), 100000 * (r / (1 - std::pow(1 + r, -12))));
+  std::vector<double> bindings = {100000, r, 12};
+  EXPECT_EQ(Annuity::evaluate(100000, r, 12),
+            calc.compile("P*r/(1-(1+r)^(-n))", {.variables = {"P", "r", "n"}}).evaluate(bindings));
+  EXPECT_EQ(s21::ct_expr<"  ">::evaluate(1.0), 0.0);
+}
+
+TEST(CtExprTests, Test1) {
+  // Ошибки области определения: тот же вид и та же позиция токена
+  s21::SmartCalcModel calc;
+  using Domain = s21::ct_expr<"1/(x-1) + ln(x) + sqrt(2-x) + asin(x-2.5) + cot(x-3)">;
+  s21::CompiledExpression compiled = calc.compile("1/(x-1) + ln(x) + sqrt(2-x) + asin(x-2.5) + cot(x-3)");
+  for (double x : {1.0, -1.0, 2.5, 3.0, 4.0, 1.5}) {
+    s21::EvalResult expected = compiled.tryEvaluate(x);
+    s21::EvalResult actual = Domain::tryEvaluate(x);
+    ASSERT_EQ(actual.has_value(), expected.has_value()) << x;
+    EXPECT_EQ(actual.error().kind, expected.error().kind) << x;
+    EXPECT_EQ(actual.error().position, expected.error().position) << x;
+    if (expected) {
+      EXPECT_EQ(actual.value(), expected.value());
+    }
+  }
+  EXPECT_THROW(Domain::evaluate(1.0), std::invalid_argument);
+  EXPECT_EQ(s21::ct_expr<"x mod 0">::tryEvaluate(2).error().kind, s21::ErrorKind::MODULO_BY_ZERO);
+  EXPECT_EQ(s21::ct_expr<"10^x">::tryEvaluate(400).error().kind, s21::ErrorKind::NOT_FINITE);
+}
+
+TEST(CtExprTests, Test2) {
+  // Разбор при компиляции отвергает те же выражения, что и модель. Вне
+  // константного вычисления ct::compile бросает исключение, что и проверяется
+  constexpr std::array<std::string_view, 1> x = {"x"};
+  constexpr auto program = s21::ct::compile<16>("sqrt(x)*2", x);
+  static_assert(program.size == 4 && program.depth == 2);
+  static_assert(program.code[1].type == s21::Type::SQRT && program.code[1].position == 0);
+  static_assert(s21::ct::parseNumber("0.1") == 0.1 && s21::ct::parseNumber("12 5.25") == 125.25);
+  s21::SmartCalcModel calc;
+  // Ошибки области определения в константах тоже отвергаются при разборе
+  for (std::string_view bad : {"", "1+", "(1", "1)", "2..3", "y", "sin", "()", "x 1", "1 + * 2", "1/0+x",
+                               "x*sqrt(1-2)", "ln(2-2)*x", "x+3 mod (1-1)", "1/0 x"}) {
+    std::string model_message, ct_message;
+    try {
+      calc.compile(bad);
+    } catch (const std::invalid_argument& e) {
+      model_message = e.what();
+    }
+    try {
+      s21::ct::compile<16>(bad, x);
+    } catch (const std::invalid_argument& e) {
+      ct_message = e.what();
+    }
+    EXPECT_FALSE(ct_message.empty()) << bad;
+    EXPECT_EQ(ct_message, model_message) << bad;
+  }
+  constexpr std::array<std::string_view, 2> duplicate = {"a", "a"};
+  EXPECT_THROW(s21::ct::compile<4>("a", duplicate), std::invalid_argument);
+}
+
+TEST(CtExprTests, Test3) {
+  // Свертка констант и понижение степеней те же, что у модели: x^3 и x^4
+  // считаются умножениями, x^0.5 от отрицательного x остается pow
+  s21::SmartCalcModel calc;
+  constexpr std::array<std::string_view, 1> x = {"x"};
+  static_assert(s21::ct::compile<8>("x^3", x).size == 5 && s21::ct::compile<8>("x^4", x).size == 6);
+  static_assert(s21::ct::compile<8>("x^4", x).temps == 1 && s21::ct::compile<16>("(2+3)*x/4", x).size == 5);
+  using Cube = s21::ct_expr<"x^3">;
+  using Fourth = s21::ct_expr<"x^4-x/8">;
+  using Shared = s21::ct_expr<"sin(x)*sin(x)+x^0.5+(1+2)">;
+  s21::CompiledExpression cube = calc.compile("x^3");
+  s21::CompiledExpression fourth = calc.compile("x^4-x/8");
+  s21::CompiledExpression shared = calc.compile("sin(x)*sin(x)+x^0.5+(1+2)");
+  EXPECT_EQ(Cube::size(), cube.size());
+  EXPECT_EQ(Fourth::size(), fourth.size());
+  EXPECT_EQ(Shared::size(), shared.size());
+  for (int k = 0; k < 2000; ++k) {
+    const double value = -100 + 200 * std::fmod(k * 0.6180339887498949, 1.0);
+    EXPECT_EQ(Cube::evaluate(value), cube.evaluate(value)) << value;
+    EXPECT_EQ(Fourth::evaluate(value), fourth.evaluate(value)) << value;
+  }
+  for (double value : {-4.0, -0.0, 0.0, 2.0}) {
+    s21::EvalResult expected = shared.tryEvaluate(value);
+    s21::EvalResult actual = Shared::tryEvaluate(value);
+    ASSERT_EQ(actual.has_value(), expected.has_value()) << value;
+    if (expected) {
+      EXPECT_EQ(actual.value(), expected.value());
+    } else {
+      EXPECT_EQ(actual.error().kind, expected.error().kind);
+      EXPECT_EQ(actual.error().position, expected.error().position);
+    }
+  }
+  EXPECT_EQ(s21::ct_expr<"x^0.5">::tryEvaluate(-4).error().kind, s21::ErrorKind::NOT_FINITE);
+  EXPECT_EQ(s21::ct_expr<"1+x^0.5">::tryEvaluate(-4).error().position, 1u);
+  EXPECT_EQ(s21::ct_expr<"(x*x)^0.5">::evaluate(-3), 3.0);
+  // Ошибка в константе, зависящая от значения функции, видна при вычислении
+  EXPECT_EQ(s21::ct_expr<"x+1/sin(0)">::tryEvaluate(1).error().kind, s21::ErrorKind::DIVISION_BY_ZERO);
+}
+
+// Сверка ct_expr с моделью: длина программы, значения до бита, вид и позиция ошибок
+template <s21::FixedString Expression>
+static void expectSameAsModel(s21::SmartCalcModel& calc) {
+  using Compiled = s21::ct_expr<Expression>;
+  const std::string text(Expression.view());
+  s21::CompiledExpression compiled = calc.compile(text);
+  EXPECT_EQ(Compiled::size(), compiled.size()) << text;
+  for (double x : {-4.0, -1.0, -0.0, 0.0, 0.5, 1.0, 2.0, 3.0, 7.25, 1e300}) {
+    s21::EvalResult expected = compiled.tryEvaluate(x);
+    s21::EvalResult actual = Compiled::tryEvaluate(x);
+    ASSERT_EQ(actual.has_value(), expected.has_value()) << text << " x=" << x;
+    if (expected) {
+      EXPECT_EQ(std::bit_cast<std::uint64_t>(actual.value()), std::bit_cast<std::uint64_t>(expected.value()))
+          << text << " x=" << x;
+    } else {
+      EXPECT_EQ(actual.error().kind, expected.error().kind) << text << " x=" << x;
+      EXPECT_EQ(actual.error().position, expected.error().position) << text << " x=" << x;
+    }
+  }
+}
+
+TEST(CtExprTests, Test4) {
+  // Таблица выражений без функций, pow и mod от констант (в них ct_expr
+  // намеренно отличается): программы и результаты совпадают с моделью
+  s21::SmartCalcModel calc;
+  expectSameAsModel<"x^2+x^3-x^4+x^1">(calc);
+  expectSameAsModel<"(x+1)*(x+1)/(x+1) - (1+x)">(calc);
+  expectSameAsModel<"x/8 - x/3 + x/0.25 + x/-2">(calc);
+  expectSameAsModel<"(2+3)*x - 1/4*x + 2*3*x + 4/5 - -x">(calc);
+  expectSameAsModel<"x^0.5 + (x*x)^0.5 + sqrt(x)^0.5 + (x+2)^0.5">(calc);
+  expectSameAsModel<"sin(x)*sin(x) + cos(x)^2 + sin(x)">(calc);
+  expectSameAsModel<"1/(x-1) + ln(x) + sqrt(2-x) + log(x*x+1)">(calc);
+  expectSameAsModel<"tan(x)/cot(x) + asin(x/4) - acos(x/4) + atan(x)^2">(calc);
+  expectSameAsModel<"x mod 2 - x^x + x mod (x-1)">(calc);
+  expectSameAsModel<"x*x*x + x*(x*x) + (x+x)*(x+x)^2">(calc);
+  expectSameAsModel<"-(x-3)^-1 * 10^x - 0.1*x">(calc);
+}